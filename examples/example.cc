@@ -38,6 +38,13 @@ int main(int argc, char *argv[]) {
   result = ast->evaluate(trace); // false
   cout << (result ? "true" : "false") << "\n";
 
+  // traces can also be stored bit-packed, one bitset per variable, which uses
+  // far less memory for long traces. read_trace_file<Trace>(path) returns this
+  // type directly.
+  Trace packed_trace(trace);
+  result = ast->evaluate(packed_trace); // false
+  cout << (result ? "true" : "false") << "\n";
+
   // calculate future reach of root node
   size_t future_reach = ast->future_reach();
   cout << "future reach: " << future_reach << "\n";
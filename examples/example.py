@@ -17,6 +17,8 @@ trace = ["101","101","001","101","101","001"]
 print(trace, ast.evaluate(trace)) # true
 trace = ["101","101","001","101","111","001"]
 print(trace, ast.evaluate(trace)) # false
+# traces can also be stored bit-packed, one bitset per variable
+print(trace, ast.evaluate(mltl.Trace(trace))) # false
 
 # calculate future reach of root node
 print("future reach:", ast.future_reach())
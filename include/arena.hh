@@ -0,0 +1,103 @@
+#pragma once
+
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <vector>
+
+#include "ast.hh"
+
+namespace libmltl {
+
+/* Owner of AST nodes that are allocated together in large slabs, instead of
+ * with one heap allocation (and control block) per node.
+ *
+ * The pointers handed out share no ownership: they are plain pointers in a
+ * std::shared_ptr, so copying them touches no reference count, and they are
+ * valid until the arena is cleared or destroyed. Nodes are released all at
+ * once, one slab at a time and without running their destructors, so the
+ * operands of a node in the arena must be in the arena as well (as they are
+ * for parse(formula, arena) and deep_copy(arena)).
+ */
+class ASTArena {
+private:
+  static constexpr size_t slab_size = (size_t)1 << 16;
+
+  std::vector<std::unique_ptr<unsigned char[]>> slabs;
+  // bytes used in the last slab
+  size_t used;
+  size_t num_nodes;
+
+  void *allocate(size_t size, size_t alignment);
+
+public:
+  ASTArena();
+  ASTArena(const ASTArena &) = delete;
+  ASTArena &operator=(const ASTArena &) = delete;
+
+  /* Constructs a node of type T in the arena.
+   */
+  template <typename T, typename... Args>
+  std::shared_ptr<T> make(Args &&...args) {
+    static_assert(std::is_base_of<ASTNode, T>::value,
+                  "an ASTArena only holds AST nodes");
+    T *node = new (allocate(sizeof(T), alignof(T)))
+        T(std::forward<Args>(args)...);
+    ++num_nodes;
+    return std::shared_ptr<T>(std::shared_ptr<T>(), node);
+  }
+
+  /* Number of nodes made since the last clear.
+   */
+  size_t size() const { return num_nodes; }
+  size_t num_slabs() const { return slabs.size(); }
+  /* Releases every node at once. The first slab is kept for reuse.
+   */
+  void clear();
+};
+
+/* Makes a node in arena, or on the heap if there is none.
+ */
+template <typename T, typename... Args>
+std::shared_ptr<ASTNode> make_node(ASTArena *arena, Args &&...args) {
+  if (arena) {
+    return arena->make<T>(std::forward<Args>(args)...);
+  }
+  return std::make_shared<T>(std::forward<Args>(args)...);
+}
+
+/* A formula that is the unique owner of its nodes. Operands refer to each
+ * other with non-owning handles, so neither reading nor copying links of the
+ * tree touches a reference count, and threads sharing the formula never
+ * write to its cache lines. The nodes live in an arena of their own, which
+ * is released together with the UniqueFormula.
+ *
+ * The tree is read-only: giving a node an operand from outside would not
+ * keep that operand alive.
+ */
+class UniqueFormula {
+private:
+  std::unique_ptr<ASTArena> arena;
+  std::shared_ptr<ASTNode> root;
+
+public:
+  UniqueFormula();
+  /* Copies formula.
+   */
+  explicit UniqueFormula(const ASTNode &formula);
+  /* Parses formula, see parser.hh.
+   */
+  explicit UniqueFormula(const std::string &formula);
+
+  bool empty() const { return !root; }
+  const ASTNode &get() const { return *root; }
+  const ASTNode &operator*() const { return *root; }
+  const ASTNode *operator->() const { return root.get(); }
+  /* A non-owning pointer to the root, for the functions that take a
+   * std::shared_ptr<ASTNode> such as evaluate_batch. It is valid for as long
+   * as this formula is, and the nodes must not be modified through it.
+   */
+  std::shared_ptr<ASTNode> handle() const { return root; }
+};
+
+} // namespace libmltl
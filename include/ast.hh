@@ -1,12 +1,32 @@
 #pragma once
 
+#include <functional>
 #include <memory>
 #include <string>
 #include <vector>
 
+#include "trace.hh"
+
 namespace libmltl {
 
+class MemoTrace;
+class ASTArena;
+
+/* Mixes value into the hash seed.
+ */
+inline size_t hash_combine(size_t seed, size_t value) {
+  return seed ^ (value + 0x9e3779b97f4a7c15 + (seed << 6) + (seed >> 2));
+}
+
 class ASTNode {
+protected:
+  // structural hash of the node apart from its type, see hash()
+  size_t hash_value = 0;
+
+  /* Recomputes hash_value from the fields and the hashes of the operands.
+   */
+  virtual void update_hash() = 0;
+
 public:
   enum class Type {
     Constant, // true,false
@@ -35,9 +55,27 @@ public:
    */
   virtual bool evaluate_subt(const std::vector<std::string> &trace,
                              size_t begin, size_t end) const = 0;
+  virtual bool evaluate_subt(const Trace &trace, size_t begin,
+                             size_t end) const = 0;
+  virtual bool evaluate_subt(const MemoTrace &trace, size_t begin,
+                             size_t end) const = 0;
   bool evaluate(const std::vector<std::string> &trace) const {
     return evaluate_subt(trace, 0, trace.size());
   };
+  bool evaluate(const Trace &trace) const {
+    return evaluate_subt(trace, 0, trace.size());
+  };
+  /* Evaluates the formula at every time step of trace at once. Bit i of the
+   * result is evaluate_subt(trace, i, trace.size()). See satisfaction.hh.
+   */
+  BitVector evaluate_all(const Trace &trace) const;
+  BitVector evaluate_all(const std::vector<std::string> &trace) const;
+  /* Like evaluate, but caches the result of every evaluate_subt call made
+   * during the evaluation, so shared sub-results of overlapping temporal
+   * windows are computed once. See memo.hh.
+   */
+  bool evaluate_memoized(const Trace &trace) const;
+  bool evaluate_memoized(const std::vector<std::string> &trace) const;
   /* Mission-time LTL (MLTL) Formula Validation Via Regular Expressions
    * https://temporallogic.org/research/WEST/WEST_extended.pdf
    * Definition 6
@@ -46,15 +84,31 @@ public:
   virtual size_t size() const = 0;
   virtual size_t depth() const = 0;
   virtual size_t count(ASTNode::Type target_type) const = 0;
+  /* Structural hash, equal for equal formulas. It is kept up to date when a
+   * node is made and by the setters of the node, so it takes O(1). Changing
+   * a subformula in place leaves the hashes of the formulas containing it
+   * stale until rehash() is called on them.
+   */
+  size_t hash() const { return hash_combine((size_t)get_type(), hash_value); }
+  /* Recomputes the hash of every node of the formula.
+   */
+  virtual void rehash() = 0;
   virtual std::shared_ptr<ASTNode> deep_copy() const = 0;
-  virtual bool operator==(const ASTNode &other) const = 0;
-  virtual bool operator!=(const ASTNode &other) const {
-    return !(*this == other);
-  }
-  virtual bool operator<(const ASTNode &other) const = 0;
-  bool operator>(const ASTNode &other) const { return other < *this; }
-  virtual bool operator<=(const ASTNode &other) const = 0;
-  bool operator>=(const ASTNode &other) const { return other <= *this; }
+  /* Copies the formula into arena, see arena.hh.
+   */
+  virtual std::shared_ptr<ASTNode> deep_copy(ASTArena &arena) const = 0;
+  /* Three-way structural comparison in one walk that stops at the first
+   * difference: negative, zero or positive if this formula orders before,
+   * equal to or after other. Formulas order by type, then by their operands
+   * from left to right, then by their value, id or bounds.
+   */
+  virtual int compare(const ASTNode &other) const = 0;
+  bool operator==(const ASTNode &other) const { return compare(other) == 0; }
+  bool operator!=(const ASTNode &other) const { return compare(other) != 0; }
+  bool operator<(const ASTNode &other) const { return compare(other) < 0; }
+  bool operator>(const ASTNode &other) const { return compare(other) > 0; }
+  bool operator<=(const ASTNode &other) const { return compare(other) <= 0; }
+  bool operator>=(const ASTNode &other) const { return compare(other) >= 0; }
   virtual ~ASTNode() = default;
 };
 
@@ -62,11 +116,17 @@ class Constant : public ASTNode {
 private:
   bool val;
 
+protected:
+  void update_hash();
+
 public:
   Constant(bool value);
 
   bool get_value() const { return val; }
-  void set_value(bool new_value) { val = new_value; }
+  void set_value(bool new_value) {
+    val = new_value;
+    update_hash();
+  }
 
   // virtual functions
   ASTNode::Type get_type() const;
@@ -79,25 +139,33 @@ public:
   std::string get_symbol() const;
   bool evaluate_subt(const std::vector<std::string> &trace, size_t begin,
                      size_t end) const;
+  bool evaluate_subt(const Trace &trace, size_t begin, size_t end) const;
+  bool evaluate_subt(const MemoTrace &trace, size_t begin, size_t end) const;
   size_t future_reach() const;
   size_t size() const;
   size_t depth() const;
   size_t count(ASTNode::Type target_type) const;
+  void rehash();
   std::shared_ptr<ASTNode> deep_copy() const;
-  bool operator==(const ASTNode &other) const;
-  bool operator<(const ASTNode &other) const;
-  bool operator<=(const ASTNode &other) const;
+  std::shared_ptr<ASTNode> deep_copy(ASTArena &arena) const;
+  int compare(const ASTNode &other) const;
 };
 
 class Variable : public ASTNode {
 private:
   unsigned int id;
 
+protected:
+  void update_hash();
+
 public:
   Variable(unsigned int id);
 
   unsigned int get_id() const { return id; }
-  void set_id(unsigned int new_id) { id = new_id; }
+  void set_id(unsigned int new_id) {
+    id = new_id;
+    update_hash();
+  }
 
   // virtual functions
   ASTNode::Type get_type() const;
@@ -110,20 +178,24 @@ public:
   std::string get_symbol() const;
   bool evaluate_subt(const std::vector<std::string> &trace, size_t begin,
                      size_t end) const;
+  bool evaluate_subt(const Trace &trace, size_t begin, size_t end) const;
+  bool evaluate_subt(const MemoTrace &trace, size_t begin, size_t end) const;
   size_t future_reach() const;
   size_t size() const;
   size_t depth() const;
   size_t count(ASTNode::Type target_type) const;
+  void rehash();
   std::shared_ptr<ASTNode> deep_copy() const;
-  bool operator==(const ASTNode &other) const;
-  bool operator<(const ASTNode &other) const;
-  bool operator<=(const ASTNode &other) const;
+  std::shared_ptr<ASTNode> deep_copy(ASTArena &arena) const;
+  int compare(const ASTNode &other) const;
 };
 
 class UnaryOp : public ASTNode {
 protected:
   std::shared_ptr<ASTNode> operand;
 
+  void update_hash();
+
 public:
   UnaryOp();
   UnaryOp(std::shared_ptr<ASTNode> operand);
@@ -132,6 +204,7 @@ public:
   ASTNode &get_operand() { return *operand; }
   void set_operand(std::shared_ptr<ASTNode> new_operand) {
     operand = std::move(new_operand);
+    update_hash();
   }
 
   // virtual functions
@@ -140,6 +213,7 @@ public:
   size_t size() const;
   size_t depth() const;
   size_t count(ASTNode::Type target_type) const;
+  void rehash();
 
   virtual ASTNode::Type get_type() const = 0;
   virtual bool is_propositional_op() const = 0;
@@ -149,11 +223,14 @@ public:
   virtual std::string get_symbol() const = 0;
   virtual bool evaluate_subt(const std::vector<std::string> &trace,
                              size_t begin, size_t end) const = 0;
+  virtual bool evaluate_subt(const Trace &trace, size_t begin,
+                             size_t end) const = 0;
+  virtual bool evaluate_subt(const MemoTrace &trace, size_t begin,
+                             size_t end) const = 0;
   virtual size_t future_reach() const = 0;
   virtual std::shared_ptr<ASTNode> deep_copy() const = 0;
-  virtual bool operator==(const ASTNode &other) const = 0;
-  virtual bool operator<(const ASTNode &other) const = 0;
-  virtual bool operator<=(const ASTNode &other) const = 0;
+  virtual std::shared_ptr<ASTNode> deep_copy(ASTArena &arena) const = 0;
+  virtual int compare(const ASTNode &other) const = 0;
 };
 
 class UnaryPropOp : public UnaryOp {
@@ -166,15 +243,18 @@ public:
   std::string as_string() const;
   std::string as_pretty_string() const;
   size_t future_reach() const;
-  bool operator==(const ASTNode &other) const;
-  bool operator<(const ASTNode &other) const;
-  bool operator<=(const ASTNode &other) const;
+  int compare(const ASTNode &other) const;
 
   virtual ASTNode::Type get_type() const = 0;
   virtual std::string get_symbol() const = 0;
   virtual bool evaluate_subt(const std::vector<std::string> &trace,
                              size_t begin, size_t end) const = 0;
+  virtual bool evaluate_subt(const Trace &trace, size_t begin,
+                             size_t end) const = 0;
+  virtual bool evaluate_subt(const MemoTrace &trace, size_t begin,
+                             size_t end) const = 0;
   virtual std::shared_ptr<ASTNode> deep_copy() const = 0;
+  virtual std::shared_ptr<ASTNode> deep_copy(ASTArena &arena) const = 0;
 };
 
 class Negation : public UnaryPropOp {
@@ -186,21 +266,32 @@ public:
   std::string get_symbol() const;
   bool evaluate_subt(const std::vector<std::string> &trace, size_t begin,
                      size_t end) const;
+  bool evaluate_subt(const Trace &trace, size_t begin, size_t end) const;
+  bool evaluate_subt(const MemoTrace &trace, size_t begin, size_t end) const;
   std::shared_ptr<ASTNode> deep_copy() const;
+  std::shared_ptr<ASTNode> deep_copy(ASTArena &arena) const;
 };
 
 class UnaryTempOp : public UnaryOp {
 protected:
   size_t lb, ub;
 
+  void update_hash();
+
 public:
   UnaryTempOp();
   UnaryTempOp(std::shared_ptr<ASTNode> operand, size_t lb, size_t ub);
 
   size_t get_lower_bound() const { return lb; }
   size_t get_upper_bound() const { return ub; }
-  void set_lower_bound(size_t new_lb) { lb = new_lb; }
-  void set_upper_bound(size_t new_ub) { ub = new_ub; }
+  void set_lower_bound(size_t new_lb) {
+    lb = new_lb;
+    update_hash();
+  }
+  void set_upper_bound(size_t new_ub) {
+    ub = new_ub;
+    update_hash();
+  }
 
   // virtual functions
   bool is_propositional_op() const;
@@ -208,15 +299,18 @@ public:
   std::string as_string() const;
   std::string as_pretty_string() const;
   size_t future_reach() const;
-  bool operator==(const ASTNode &other) const;
-  bool operator<(const ASTNode &other) const;
-  bool operator<=(const ASTNode &other) const;
+  int compare(const ASTNode &other) const;
 
   virtual ASTNode::Type get_type() const = 0;
   virtual std::string get_symbol() const = 0;
   virtual bool evaluate_subt(const std::vector<std::string> &trace,
                              size_t begin, size_t end) const = 0;
+  virtual bool evaluate_subt(const Trace &trace, size_t begin,
+                             size_t end) const = 0;
+  virtual bool evaluate_subt(const MemoTrace &trace, size_t begin,
+                             size_t end) const = 0;
   virtual std::shared_ptr<ASTNode> deep_copy() const = 0;
+  virtual std::shared_ptr<ASTNode> deep_copy(ASTArena &arena) const = 0;
 };
 
 class Finally : public UnaryTempOp {
@@ -228,7 +322,10 @@ public:
   std::string get_symbol() const;
   bool evaluate_subt(const std::vector<std::string> &trace, size_t begin,
                      size_t end) const;
+  bool evaluate_subt(const Trace &trace, size_t begin, size_t end) const;
+  bool evaluate_subt(const MemoTrace &trace, size_t begin, size_t end) const;
   std::shared_ptr<ASTNode> deep_copy() const;
+  std::shared_ptr<ASTNode> deep_copy(ASTArena &arena) const;
 };
 
 class Globally : public UnaryTempOp {
@@ -240,13 +337,18 @@ public:
   std::string get_symbol() const;
   bool evaluate_subt(const std::vector<std::string> &trace, size_t begin,
                      size_t end) const;
+  bool evaluate_subt(const Trace &trace, size_t begin, size_t end) const;
+  bool evaluate_subt(const MemoTrace &trace, size_t begin, size_t end) const;
   std::shared_ptr<ASTNode> deep_copy() const;
+  std::shared_ptr<ASTNode> deep_copy(ASTArena &arena) const;
 };
 
 class BinaryOp : public ASTNode {
 protected:
   std::shared_ptr<ASTNode> left, right;
 
+  void update_hash();
+
 public:
   BinaryOp();
   BinaryOp(std::shared_ptr<ASTNode> left, std::shared_ptr<ASTNode> right);
@@ -257,9 +359,11 @@ public:
   ASTNode &get_right() { return *right; }
   void set_left(std::shared_ptr<ASTNode> new_left) {
     left = std::move(new_left);
+    update_hash();
   }
   void set_right(std::shared_ptr<ASTNode> new_right) {
-    left = std::move(new_right);
+    right = std::move(new_right);
+    update_hash();
   }
 
   // virtual functions
@@ -268,6 +372,7 @@ public:
   size_t size() const;
   size_t depth() const;
   size_t count(ASTNode::Type target_type) const;
+  void rehash();
 
   virtual ASTNode::Type get_type() const = 0;
   virtual bool is_propositional_op() const = 0;
@@ -277,11 +382,14 @@ public:
   virtual std::string get_symbol() const = 0;
   virtual bool evaluate_subt(const std::vector<std::string> &trace,
                              size_t begin, size_t end) const = 0;
+  virtual bool evaluate_subt(const Trace &trace, size_t begin,
+                             size_t end) const = 0;
+  virtual bool evaluate_subt(const MemoTrace &trace, size_t begin,
+                             size_t end) const = 0;
   virtual size_t future_reach() const = 0;
   virtual std::shared_ptr<ASTNode> deep_copy() const = 0;
-  virtual bool operator==(const ASTNode &other) const = 0;
-  virtual bool operator<(const ASTNode &other) const = 0;
-  virtual bool operator<=(const ASTNode &other) const = 0;
+  virtual std::shared_ptr<ASTNode> deep_copy(ASTArena &arena) const = 0;
+  virtual int compare(const ASTNode &other) const = 0;
 };
 
 class BinaryPropOp : public BinaryOp {
@@ -294,15 +402,18 @@ public:
   std::string as_string() const;
   std::string as_pretty_string() const;
   size_t future_reach() const;
-  bool operator==(const ASTNode &other) const;
-  bool operator<(const ASTNode &other) const;
-  bool operator<=(const ASTNode &other) const;
+  int compare(const ASTNode &other) const;
 
   virtual ASTNode::Type get_type() const = 0;
   virtual std::string get_symbol() const = 0;
   virtual bool evaluate_subt(const std::vector<std::string> &trace,
                              size_t begin, size_t end) const = 0;
+  virtual bool evaluate_subt(const Trace &trace, size_t begin,
+                             size_t end) const = 0;
+  virtual bool evaluate_subt(const MemoTrace &trace, size_t begin,
+                             size_t end) const = 0;
   virtual std::shared_ptr<ASTNode> deep_copy() const = 0;
+  virtual std::shared_ptr<ASTNode> deep_copy(ASTArena &arena) const = 0;
 };
 
 class And : public BinaryPropOp {
@@ -314,7 +425,10 @@ public:
   std::string get_symbol() const;
   bool evaluate_subt(const std::vector<std::string> &trace, size_t begin,
                      size_t end) const;
+  bool evaluate_subt(const Trace &trace, size_t begin, size_t end) const;
+  bool evaluate_subt(const MemoTrace &trace, size_t begin, size_t end) const;
   std::shared_ptr<ASTNode> deep_copy() const;
+  std::shared_ptr<ASTNode> deep_copy(ASTArena &arena) const;
 };
 
 class Xor : public BinaryPropOp {
@@ -326,7 +440,10 @@ public:
   std::string get_symbol() const;
   bool evaluate_subt(const std::vector<std::string> &trace, size_t begin,
                      size_t end) const;
+  bool evaluate_subt(const Trace &trace, size_t begin, size_t end) const;
+  bool evaluate_subt(const MemoTrace &trace, size_t begin, size_t end) const;
   std::shared_ptr<ASTNode> deep_copy() const;
+  std::shared_ptr<ASTNode> deep_copy(ASTArena &arena) const;
 };
 
 class Or : public BinaryPropOp {
@@ -338,7 +455,10 @@ public:
   std::string get_symbol() const;
   bool evaluate_subt(const std::vector<std::string> &trace, size_t begin,
                      size_t end) const;
+  bool evaluate_subt(const Trace &trace, size_t begin, size_t end) const;
+  bool evaluate_subt(const MemoTrace &trace, size_t begin, size_t end) const;
   std::shared_ptr<ASTNode> deep_copy() const;
+  std::shared_ptr<ASTNode> deep_copy(ASTArena &arena) const;
 };
 
 class Implies : public BinaryPropOp {
@@ -350,7 +470,10 @@ public:
   std::string get_symbol() const;
   bool evaluate_subt(const std::vector<std::string> &trace, size_t begin,
                      size_t end) const;
+  bool evaluate_subt(const Trace &trace, size_t begin, size_t end) const;
+  bool evaluate_subt(const MemoTrace &trace, size_t begin, size_t end) const;
   std::shared_ptr<ASTNode> deep_copy() const;
+  std::shared_ptr<ASTNode> deep_copy(ASTArena &arena) const;
 };
 
 class Equiv : public BinaryPropOp {
@@ -362,13 +485,18 @@ public:
   std::string get_symbol() const;
   bool evaluate_subt(const std::vector<std::string> &trace, size_t begin,
                      size_t end) const;
+  bool evaluate_subt(const Trace &trace, size_t begin, size_t end) const;
+  bool evaluate_subt(const MemoTrace &trace, size_t begin, size_t end) const;
   std::shared_ptr<ASTNode> deep_copy() const;
+  std::shared_ptr<ASTNode> deep_copy(ASTArena &arena) const;
 };
 
 class BinaryTempOp : public BinaryOp {
 protected:
   size_t lb, ub;
 
+  void update_hash();
+
 public:
   BinaryTempOp();
   BinaryTempOp(std::shared_ptr<ASTNode> left, std::shared_ptr<ASTNode> right,
@@ -376,8 +504,14 @@ public:
 
   size_t get_lower_bound() const { return lb; }
   size_t get_upper_bound() const { return ub; }
-  void set_lower_bound(size_t new_lb) { lb = new_lb; }
-  void set_upper_bound(size_t new_ub) { ub = new_ub; }
+  void set_lower_bound(size_t new_lb) {
+    lb = new_lb;
+    update_hash();
+  }
+  void set_upper_bound(size_t new_ub) {
+    ub = new_ub;
+    update_hash();
+  }
 
   // virtual functions
   bool is_propositional_op() const;
@@ -385,15 +519,18 @@ public:
   std::string as_string() const;
   std::string as_pretty_string() const;
   size_t future_reach() const;
-  bool operator==(const ASTNode &other) const;
-  bool operator<(const ASTNode &other) const;
-  bool operator<=(const ASTNode &other) const;
+  int compare(const ASTNode &other) const;
 
   virtual ASTNode::Type get_type() const = 0;
   virtual std::string get_symbol() const = 0;
   virtual bool evaluate_subt(const std::vector<std::string> &trace,
                              size_t begin, size_t end) const = 0;
+  virtual bool evaluate_subt(const Trace &trace, size_t begin,
+                             size_t end) const = 0;
+  virtual bool evaluate_subt(const MemoTrace &trace, size_t begin,
+                             size_t end) const = 0;
   virtual std::shared_ptr<ASTNode> deep_copy() const = 0;
+  virtual std::shared_ptr<ASTNode> deep_copy(ASTArena &arena) const = 0;
 };
 
 class Until : public BinaryTempOp {
@@ -405,7 +542,10 @@ public:
   std::string get_symbol() const;
   bool evaluate_subt(const std::vector<std::string> &trace, size_t begin,
                      size_t end) const;
+  bool evaluate_subt(const Trace &trace, size_t begin, size_t end) const;
+  bool evaluate_subt(const MemoTrace &trace, size_t begin, size_t end) const;
   std::shared_ptr<ASTNode> deep_copy() const;
+  std::shared_ptr<ASTNode> deep_copy(ASTArena &arena) const;
 };
 
 class Release : public BinaryTempOp {
@@ -417,7 +557,22 @@ public:
   std::string get_symbol() const;
   bool evaluate_subt(const std::vector<std::string> &trace, size_t begin,
                      size_t end) const;
+  bool evaluate_subt(const Trace &trace, size_t begin, size_t end) const;
+  bool evaluate_subt(const MemoTrace &trace, size_t begin, size_t end) const;
   std::shared_ptr<ASTNode> deep_copy() const;
+  std::shared_ptr<ASTNode> deep_copy(ASTArena &arena) const;
 };
 
 } // namespace libmltl
+
+namespace std {
+
+/* Structural hash, so that formulas can key unordered containers.
+ */
+template <> struct hash<libmltl::ASTNode> {
+  size_t operator()(const libmltl::ASTNode &formula) const {
+    return formula.hash();
+  }
+};
+
+} // namespace std
@@ -0,0 +1,77 @@
+#pragma once
+
+#include "ast.hh"
+#include "thread_pool.hh"
+
+namespace libmltl {
+
+/* A group of traces of the same length stored bit-sliced: for every variable
+ * and time step there are num_lanes() consecutive words, and bit k of word w
+ * holds the value of that variable in trace 64 * w + k. Operators then compute
+ * the verdicts of 64 traces per machine word, and a batch of 256 traces fills
+ * an AVX2 register.
+ *
+ * Traces that have fewer variables than others read the missing ones as 0,
+ * exactly like ASTNode::evaluate does.
+ */
+class TraceBatch {
+private:
+  size_t len;
+  size_t vars;
+  size_t count;
+  size_t lanes;
+  // indexed by [variable][time step][lane]
+  std::vector<uint64_t> bits;
+
+  void init(size_t num_traces, size_t length, size_t num_vars);
+
+public:
+  TraceBatch();
+  /* Transposes traces[begin, end) (or all of traces). Throws
+   * std::invalid_argument if the traces are not all the same length.
+   */
+  explicit TraceBatch(const std::vector<Trace> &traces);
+  TraceBatch(const std::vector<Trace> &traces, size_t begin, size_t end);
+  explicit TraceBatch(const std::vector<std::vector<std::string>> &traces);
+  TraceBatch(const std::vector<std::vector<std::string>> &traces,
+             size_t begin, size_t end);
+
+  size_t size() const { return len; }
+  size_t num_vars() const { return vars; }
+  size_t num_traces() const { return count; }
+  size_t num_lanes() const { return lanes; }
+  /* Returns the num_lanes() words holding variable id at time step t.
+   */
+  const uint64_t *get_variable(unsigned int id, size_t t) const {
+    return &bits[(id * len + t) * lanes];
+  }
+};
+
+/* Evaluates formula over every trace of batch at once. Bit k of the result is
+ * formula.evaluate(trace k).
+ */
+BitVector evaluate_batch(const ASTNode &formula, const TraceBatch &batch);
+
+/* Evaluates every formula over every trace. Bit k of row i of the result is
+ * formulas[i]->evaluate(traces[k]).
+ *
+ * The matrix is split into tiles of a block of traces (a multiple of 64,
+ * small enough for its TraceBatch to stay in L2) and a block of formulas, and
+ * the tiles run on pool, or on num_threads new threads (0 means one per
+ * hardware thread). Tiles of the same block of traces are neighbouring tasks,
+ * so they mostly run one after the other on the same thread. Traces of equal
+ * length are evaluated bit-sliced; a block of traces of different lengths
+ * falls back to evaluating them one at a time.
+ */
+std::vector<BitVector>
+evaluate_batch(const std::vector<std::shared_ptr<ASTNode>> &formulas,
+               const std::vector<Trace> &traces, ThreadPool &pool);
+std::vector<BitVector>
+evaluate_batch(const std::vector<std::shared_ptr<ASTNode>> &formulas,
+               const std::vector<Trace> &traces, unsigned int num_threads = 0);
+std::vector<BitVector>
+evaluate_batch(const std::vector<std::shared_ptr<ASTNode>> &formulas,
+               const std::vector<std::vector<std::string>> &traces,
+               unsigned int num_threads = 0);
+
+} // namespace libmltl
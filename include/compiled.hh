@@ -0,0 +1,63 @@
+#pragma once
+
+#include <cstdint>
+
+#include "ast.hh"
+
+namespace libmltl {
+
+/* A formula compiled to a flat postfix program.
+ *
+ * Every instruction computes the satisfaction vector of one subformula into
+ * its own register from the registers of its operands, which always come
+ * earlier in the program. Evaluation is a single loop over the instructions
+ * with the word-level kernels of kernels.hh, restricted to the prefix of the
+ * trace that can decide the verdict (see evaluation_reach), and needs no
+ * virtual calls, reference counting or pointer chasing through the AST.
+ */
+class CompiledFormula {
+public:
+  enum class Opcode : uint8_t {
+    Constant, // lb holds the value
+    Variable, // lb holds the id
+    Negation,
+    And,
+    Xor,
+    Or,
+    Implies,
+    Equiv,
+    Finally,
+    Globally,
+    Until,
+    Release,
+  };
+  struct Instruction {
+    Opcode op;
+    // registers (= instruction indices) of the operands
+    uint32_t left, right;
+    size_t lb, ub;
+  };
+
+private:
+  std::vector<Instruction> program;
+  size_t reach;
+
+  uint32_t compile(const ASTNode &formula);
+
+public:
+  CompiledFormula();
+  explicit CompiledFormula(const ASTNode &formula);
+
+  const std::vector<Instruction> &get_program() const { return program; }
+  size_t size() const { return program.size(); }
+  /* Same as evaluation_reach() of the source formula.
+   */
+  size_t evaluation_reach() const { return reach; }
+  /* Same result as ASTNode::evaluate. The registers are kept in a
+   * thread-local buffer, so repeated evaluation does not allocate.
+   */
+  bool evaluate(const Trace &trace) const;
+  bool evaluate(const std::vector<std::string> &trace) const;
+};
+
+} // namespace libmltl
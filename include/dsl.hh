@@ -0,0 +1,264 @@
+#pragma once
+
+#include <algorithm>
+#include <type_traits>
+
+#include "ast.hh"
+
+namespace libmltl {
+
+/* Formulas fixed at compile time, written as C++ expressions:
+ *
+ *   using namespace libmltl::dsl;
+ *   auto spec = G<0, 10>(p<0> && !p<1>);
+ *   spec.evaluate(trace);
+ *
+ * The type of an expression encodes the whole formula, with the operators as
+ * ASTNode::Type and the bounds as template parameters. Expressions have no
+ * state and evaluate_subt is a static member, so evaluation involves no
+ * virtual calls or allocation and is inlined and constant-folded by the
+ * compiler. It follows the same semantics as ASTNode::evaluate_subt.
+ *
+ * to_ast() builds the equivalent runtime formula, which equals the result of
+ * parse() for the same formula.
+ */
+namespace dsl {
+
+struct ExprTag {};
+
+template <typename E>
+constexpr bool is_expr_v = std::is_base_of_v<ExprTag, E>;
+
+/* Base of all expressions, E is the derived type.
+ */
+template <typename E> struct Expr : ExprTag {
+  static bool evaluate(const std::vector<std::string> &trace) {
+    return E::evaluate_subt(trace, 0, trace.size());
+  }
+  static bool evaluate(const Trace &trace) {
+    return E::evaluate_subt(trace, 0, trace.size());
+  }
+};
+
+template <bool Value> struct ConstantExpr : Expr<ConstantExpr<Value>> {
+  static constexpr ASTNode::Type type = ASTNode::Type::Constant;
+
+  template <typename T>
+  static bool evaluate_subt(const T &, size_t, size_t) {
+    return Value;
+  }
+  static std::shared_ptr<ASTNode> to_ast() {
+    return std::make_shared<Constant>(Value);
+  }
+};
+
+template <unsigned int Id> struct VariableExpr : Expr<VariableExpr<Id>> {
+  static constexpr ASTNode::Type type = ASTNode::Type::Variable;
+
+  static bool evaluate_subt(const std::vector<std::string> &trace,
+                            size_t begin, size_t end) {
+    if (begin == end || Id >= trace[0].length()) {
+      return false;
+    }
+    return (trace[begin][Id] == '1');
+  }
+  static bool evaluate_subt(const Trace &trace, size_t begin, size_t end) {
+    return begin != end && trace.get(Id, begin);
+  }
+  static std::shared_ptr<ASTNode> to_ast() {
+    return std::make_shared<Variable>(Id);
+  }
+};
+
+template <typename Operand>
+struct NegationExpr : Expr<NegationExpr<Operand>> {
+  static constexpr ASTNode::Type type = ASTNode::Type::Negation;
+
+  template <typename T>
+  static bool evaluate_subt(const T &trace, size_t begin, size_t end) {
+    return !Operand::evaluate_subt(trace, begin, end);
+  }
+  static std::shared_ptr<ASTNode> to_ast() {
+    return std::make_shared<Negation>(Operand::to_ast());
+  }
+};
+
+template <ASTNode::Type Op, typename Left, typename Right>
+struct BinaryPropExpr : Expr<BinaryPropExpr<Op, Left, Right>> {
+  static constexpr ASTNode::Type type = Op;
+
+  template <typename T>
+  static bool evaluate_subt(const T &trace, size_t begin, size_t end) {
+    if constexpr (Op == ASTNode::Type::And) {
+      return Left::evaluate_subt(trace, begin, end) &&
+             Right::evaluate_subt(trace, begin, end);
+    } else if constexpr (Op == ASTNode::Type::Xor) {
+      return Left::evaluate_subt(trace, begin, end) !=
+             Right::evaluate_subt(trace, begin, end);
+    } else if constexpr (Op == ASTNode::Type::Or) {
+      return Left::evaluate_subt(trace, begin, end) ||
+             Right::evaluate_subt(trace, begin, end);
+    } else if constexpr (Op == ASTNode::Type::Implies) {
+      return !Left::evaluate_subt(trace, begin, end) ||
+             Right::evaluate_subt(trace, begin, end);
+    } else {
+      static_assert(Op == ASTNode::Type::Equiv);
+      return Left::evaluate_subt(trace, begin, end) ==
+             Right::evaluate_subt(trace, begin, end);
+    }
+  }
+  static std::shared_ptr<ASTNode> to_ast() {
+    std::shared_ptr<ASTNode> left = Left::to_ast(), right = Right::to_ast();
+    if constexpr (Op == ASTNode::Type::And) {
+      return std::make_shared<And>(left, right);
+    } else if constexpr (Op == ASTNode::Type::Xor) {
+      return std::make_shared<Xor>(left, right);
+    } else if constexpr (Op == ASTNode::Type::Or) {
+      return std::make_shared<Or>(left, right);
+    } else if constexpr (Op == ASTNode::Type::Implies) {
+      return std::make_shared<Implies>(left, right);
+    } else {
+      return std::make_shared<Equiv>(left, right);
+    }
+  }
+};
+
+template <ASTNode::Type Op, size_t Lb, size_t Ub, typename Operand>
+struct UnaryTempExpr : Expr<UnaryTempExpr<Op, Lb, Ub, Operand>> {
+  static_assert(Op == ASTNode::Type::Finally ||
+                Op == ASTNode::Type::Globally);
+  static_assert(Lb <= Ub, "lower bound must not exceed the upper bound");
+  static constexpr ASTNode::Type type = Op;
+
+  template <typename T>
+  static bool evaluate_subt(const T &trace, size_t begin, size_t end) {
+    // F looks for a true operand, G for a false one
+    constexpr bool finally = (Op == ASTNode::Type::Finally);
+    if (end - begin <= Lb) {
+      return !finally;
+    }
+    size_t idx_end = std::min(begin + Ub + 1, end);
+    for (size_t k = begin + Lb; k < idx_end; ++k) {
+      if (Operand::evaluate_subt(trace, k, end) == finally) {
+        return finally;
+      }
+    }
+    return !finally;
+  }
+  static std::shared_ptr<ASTNode> to_ast() {
+    if constexpr (Op == ASTNode::Type::Finally) {
+      return std::make_shared<Finally>(Operand::to_ast(), Lb, Ub);
+    } else {
+      return std::make_shared<Globally>(Operand::to_ast(), Lb, Ub);
+    }
+  }
+};
+
+template <ASTNode::Type Op, size_t Lb, size_t Ub, typename Left,
+          typename Right>
+struct BinaryTempExpr : Expr<BinaryTempExpr<Op, Lb, Ub, Left, Right>> {
+  static_assert(Op == ASTNode::Type::Until || Op == ASTNode::Type::Release);
+  static_assert(Lb <= Ub, "lower bound must not exceed the upper bound");
+  static constexpr ASTNode::Type type = Op;
+
+  template <typename T>
+  static bool evaluate_subt(const T &trace, size_t begin, size_t end) {
+    constexpr bool until = (Op == ASTNode::Type::Until);
+    if (end - begin <= Lb) {
+      return !until;
+    }
+    size_t idx_end = std::min(begin + Ub + 1, end);
+    for (size_t k = begin + Lb; k < idx_end; ++k) {
+      if constexpr (until) {
+        // the first witness of right decides, left must hold before it
+        if (Right::evaluate_subt(trace, k, end)) {
+          return true;
+        }
+        if (!Left::evaluate_subt(trace, k, end)) {
+          return false;
+        }
+      } else {
+        // right must hold until (and including where) left releases it
+        if (!Right::evaluate_subt(trace, k, end)) {
+          return false;
+        }
+        if (Left::evaluate_subt(trace, k, end)) {
+          return true;
+        }
+      }
+    }
+    return !until;
+  }
+  static std::shared_ptr<ASTNode> to_ast() {
+    if constexpr (Op == ASTNode::Type::Until) {
+      return std::make_shared<Until>(Left::to_ast(), Right::to_ast(), Lb, Ub);
+    } else {
+      return std::make_shared<Release>(Left::to_ast(), Right::to_ast(), Lb,
+                                       Ub);
+    }
+  }
+};
+
+/* Leaves.
+ */
+inline constexpr ConstantExpr<true> tt{};
+inline constexpr ConstantExpr<false> ff{};
+template <unsigned int Id> inline constexpr VariableExpr<Id> p{};
+
+/* Propositional operators.
+ */
+template <typename E, typename = std::enable_if_t<is_expr_v<E>>>
+constexpr NegationExpr<E> operator!(E) {
+  return {};
+}
+template <typename A, typename B,
+          typename = std::enable_if_t<is_expr_v<A> && is_expr_v<B>>>
+constexpr BinaryPropExpr<ASTNode::Type::And, A, B> operator&&(A, B) {
+  return {};
+}
+template <typename A, typename B,
+          typename = std::enable_if_t<is_expr_v<A> && is_expr_v<B>>>
+constexpr BinaryPropExpr<ASTNode::Type::Xor, A, B> operator^(A, B) {
+  return {};
+}
+template <typename A, typename B,
+          typename = std::enable_if_t<is_expr_v<A> && is_expr_v<B>>>
+constexpr BinaryPropExpr<ASTNode::Type::Or, A, B> operator||(A, B) {
+  return {};
+}
+template <typename A, typename B,
+          typename = std::enable_if_t<is_expr_v<A> && is_expr_v<B>>>
+constexpr BinaryPropExpr<ASTNode::Type::Implies, A, B> implies(A, B) {
+  return {};
+}
+template <typename A, typename B,
+          typename = std::enable_if_t<is_expr_v<A> && is_expr_v<B>>>
+constexpr BinaryPropExpr<ASTNode::Type::Equiv, A, B> equiv(A, B) {
+  return {};
+}
+
+/* Temporal operators.
+ */
+template <size_t Lb, size_t Ub, typename E,
+          typename = std::enable_if_t<is_expr_v<E>>>
+constexpr UnaryTempExpr<ASTNode::Type::Finally, Lb, Ub, E> F(E) {
+  return {};
+}
+template <size_t Lb, size_t Ub, typename E,
+          typename = std::enable_if_t<is_expr_v<E>>>
+constexpr UnaryTempExpr<ASTNode::Type::Globally, Lb, Ub, E> G(E) {
+  return {};
+}
+template <size_t Lb, size_t Ub, typename A, typename B,
+          typename = std::enable_if_t<is_expr_v<A> && is_expr_v<B>>>
+constexpr BinaryTempExpr<ASTNode::Type::Until, Lb, Ub, A, B> U(A, B) {
+  return {};
+}
+template <size_t Lb, size_t Ub, typename A, typename B,
+          typename = std::enable_if_t<is_expr_v<A> && is_expr_v<B>>>
+constexpr BinaryTempExpr<ASTNode::Type::Release, Lb, Ub, A, B> R(A, B) {
+  return {};
+}
+
+} // namespace dsl
+} // namespace libmltl
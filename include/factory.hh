@@ -0,0 +1,64 @@
+#pragma once
+
+#include <type_traits>
+#include <unordered_map>
+
+#include "ast.hh"
+
+namespace libmltl {
+
+/* Makes hash-consed (interned) formulas: all structurally equal formulas
+ * made by one factory are the same node. Equal subformulas are then shared
+ * instead of repeated, two formulas of the factory are equal iff their
+ * pointers are, and caches can key on node identity.
+ *
+ * The factory keeps every node it made alive until it is cleared. Its nodes
+ * are shared by all the formulas that contain them, so they must not be
+ * modified.
+ */
+class FormulaFactory {
+private:
+  // a node by its type, fields and (interned) operands
+  struct Key {
+    ASTNode::Type type;
+    // bounds, or id of a variable or value of a constant in lb
+    size_t lb, ub;
+    const ASTNode *left, *right;
+
+    bool operator==(const Key &other) const {
+      return type == other.type && lb == other.lb && ub == other.ub &&
+             left == other.left && right == other.right;
+    }
+  };
+  struct KeyHash {
+    size_t operator()(const Key &key) const;
+  };
+
+  std::unordered_map<Key, std::shared_ptr<ASTNode>, KeyHash> nodes;
+
+  std::shared_ptr<ASTNode> get(ASTNode::Type type, size_t lb, size_t ub,
+                               const std::shared_ptr<ASTNode> &left,
+                               const std::shared_ptr<ASTNode> &right);
+
+public:
+  /* Returns the node of the factory equal to formula, and makes it (and the
+   * missing subformulas) if there is none. Takes O(1) for a formula of the
+   * factory or one whose operands are, and O(size) otherwise.
+   */
+  std::shared_ptr<ASTNode> intern(const ASTNode &formula);
+  /* Returns the node of the factory equal to T(args...).
+   */
+  template <typename T, typename... Args>
+  std::shared_ptr<ASTNode> make(Args &&...args) {
+    static_assert(std::is_base_of<ASTNode, T>::value,
+                  "a FormulaFactory only makes AST nodes");
+    return intern(T(std::forward<Args>(args)...));
+  }
+
+  /* Number of distinct nodes made.
+   */
+  size_t size() const { return nodes.size(); }
+  void clear() { nodes.clear(); }
+};
+
+} // namespace libmltl
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <cstdint>
+
+#include "arena.hh"
+#include "ast.hh"
+
+namespace libmltl {
+
+/* A formula stored as parallel arrays, one entry per node, in postfix order:
+ * the operands of a node always come before it, and the root is last.
+ *
+ * The structural analyses of ASTNode are single linear scans over these
+ * arrays, without virtual calls or pointer chasing through the heap. Fields
+ * that a node does not use are 0, so two formulas are equal exactly when
+ * their arrays are.
+ */
+class FlatFormula {
+private:
+  std::vector<ASTNode::Type> types;
+  // bounds of the temporal operators
+  std::vector<size_t> lbs, ubs;
+  // indices of the operands, the operand of a unary operator is on the left
+  std::vector<uint32_t> lefts, rights;
+  // id of a variable, or value of a constant
+  std::vector<unsigned int> values;
+
+  uint32_t flatten(const ASTNode &formula);
+  std::shared_ptr<ASTNode> to_ast(ASTArena *arena) const;
+
+public:
+  // the constant false
+  FlatFormula();
+  explicit FlatFormula(const ASTNode &formula);
+
+  /* Converts back into a tree on the heap, or in arena.
+   */
+  std::shared_ptr<ASTNode> to_ast() const;
+  std::shared_ptr<ASTNode> to_ast(ASTArena &arena) const;
+
+  const std::vector<ASTNode::Type> &get_types() const { return types; }
+  const std::vector<size_t> &get_lower_bounds() const { return lbs; }
+  const std::vector<size_t> &get_upper_bounds() const { return ubs; }
+  const std::vector<uint32_t> &get_lefts() const { return lefts; }
+  const std::vector<uint32_t> &get_rights() const { return rights; }
+  const std::vector<unsigned int> &get_values() const { return values; }
+
+  /* Same results as the functions of ASTNode on the source formula.
+   */
+  size_t future_reach() const;
+  size_t size() const { return types.size(); }
+  size_t depth() const;
+  size_t count(ASTNode::Type target_type) const;
+  bool operator==(const FlatFormula &other) const;
+  bool operator!=(const FlatFormula &other) const { return !(*this == other); }
+};
+
+} // namespace libmltl
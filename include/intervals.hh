@@ -0,0 +1,92 @@
+#pragma once
+
+#include "ast.hh"
+
+namespace libmltl {
+
+/* Set of time steps stored as sorted, disjoint and non-adjacent intervals
+ * [begin, end). A signal that rarely changes takes a few intervals however
+ * long the trace is.
+ */
+class IntervalSet {
+private:
+  // begin and end of every interval, in order
+  std::vector<size_t> bounds;
+
+public:
+  IntervalSet();
+  /* The time steps whose bit is set.
+   */
+  explicit IntervalSet(const BitVector &bits);
+
+  size_t num_intervals() const { return bounds.size() / 2; }
+  size_t begin(size_t k) const { return bounds[2 * k]; }
+  size_t end(size_t k) const { return bounds[2 * k + 1]; }
+  bool empty() const { return bounds.empty(); }
+
+  /* Adds [begin, end), which must not start before the last interval. It is
+   * merged with the last interval if they overlap or touch.
+   */
+  void push_back(size_t begin, size_t end);
+  bool contains(size_t t) const;
+  /* Returns the number of time steps in the set.
+   */
+  size_t count() const;
+  /* Returns the set as a BitVector of length len, which must not be less than
+   * the end of the last interval.
+   */
+  BitVector to_bitvector(size_t len) const;
+  bool operator==(const IntervalSet &other) const {
+    return bounds == other.bounds;
+  }
+  bool operator!=(const IntervalSet &other) const { return !(*this == other); }
+};
+
+/* Run-length encoded trace: for every variable, the set of time steps where
+ * it holds. It behaves like Trace under evaluation, the number of variables
+ * is taken from the first state.
+ */
+class IntervalTrace {
+private:
+  size_t len;
+  std::vector<IntervalSet> columns;
+
+public:
+  IntervalTrace();
+  IntervalTrace(size_t length, const std::vector<IntervalSet> &columns);
+  explicit IntervalTrace(const Trace &trace);
+  explicit IntervalTrace(const std::vector<std::string> &trace);
+
+  size_t size() const { return len; }
+  size_t num_vars() const { return columns.size(); }
+  const IntervalSet &get_variable(unsigned int id) const {
+    return columns[id];
+  }
+
+  /* Appends a state given as a string of 0s and 1s, like Trace::push_back.
+   * This lets read_trace_file<IntervalTrace> load a file without a dense
+   * copy.
+   */
+  void push_back(const std::string &state);
+  Trace to_trace() const;
+};
+
+/* Bottom-up evaluation over run-length encoded satisfaction sets. The result
+ * is the set of time steps i where
+ *   formula.evaluate_subt(trace, i, trace.size())
+ * holds, so it equals evaluate_all as a set, and contains(0) is the verdict
+ * of formula.evaluate(trace).
+ *
+ * Propositional operators merge the interval lists of their operands.
+ * F[a,b] shifts every interval [s, e) of its operand to [s - b, e - a)
+ * (Minkowski difference with the window), G[a,b] is the complement of
+ * F[a,b] of the complement, and U[a,b] extends every interval [s, e) of its
+ * right operand backwards over the part of the preceding interval of the left
+ * operand that lies within b - a of s, then shifts by a; R is its dual. The
+ * cost is linear in the number of intervals of the operands and independent
+ * of the length of the trace and of the bounds.
+ */
+IntervalSet evaluate_intervals(const ASTNode &formula,
+                               const IntervalTrace &trace);
+
+} // namespace libmltl
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <cstdint>
+
+#include "ast.hh"
+
+namespace libmltl {
+
+/* Windows of at most this many positions are unrolled in generated code.
+ */
+constexpr size_t jit_unroll_limit = 4;
+
+/* A formula compiled to native code at runtime.
+ *
+ * The formula is translated to C++ with one function per distinct
+ * subformula that mirrors ASTNode::evaluate_subt, with the bounds inlined as
+ * constants and the loops over windows of up to jit_unroll_limit positions
+ * unrolled. The source is compiled with the local C++ compiler (g++, or
+ * $LIBMLTL_JIT_CXX) into a shared object that is loaded with dlopen.
+ *
+ * Shared objects are cached in cache_dir under a hash of as_string(), so
+ * constructing a JitFormula for a formula that was compiled before, also by
+ * an earlier process, only loads it. cache_dir is created with mode 0700 if
+ * missing. Only a cache_dir and objects owned by the effective user and not
+ * writable by group or others are trusted; otherwise the formula is compiled
+ * in a private temporary directory and not cached. Throws
+ * std::runtime_error if the code can not be compiled or loaded.
+ */
+class JitFormula {
+private:
+  typedef bool (*EvaluateFunction)(const uint64_t *const *columns,
+                                   size_t num_vars, size_t n);
+  std::string formula;
+  void *handle;
+  EvaluateFunction function;
+  bool cached;
+
+  bool load(const std::string &path);
+
+public:
+  explicit JitFormula(const ASTNode &formula,
+                      const std::string &cache_dir = jit_cache_dir());
+  JitFormula(const JitFormula &) = delete;
+  JitFormula &operator=(const JitFormula &) = delete;
+  JitFormula(JitFormula &&other) noexcept;
+  JitFormula &operator=(JitFormula &&other) noexcept;
+  ~JitFormula();
+
+  /* Same result as ASTNode::evaluate.
+   */
+  bool evaluate(const Trace &trace) const;
+  bool evaluate(const std::vector<std::string> &trace) const;
+  /* Whether the shared object was found in the cache instead of compiled.
+   */
+  bool loaded_from_cache() const { return cached; }
+
+  /* $LIBMLTL_JIT_CACHE if set, otherwise libmltl-jit in $XDG_CACHE_HOME or,
+   * failing that, in ~/.cache.
+   */
+  static std::string jit_cache_dir();
+  /* The C++ source generated for formula.
+   */
+  static std::string generate_source(const ASTNode &formula);
+};
+
+} // namespace libmltl
@@ -0,0 +1,107 @@
+#pragma once
+
+#include "trace.hh"
+
+namespace libmltl {
+
+/* Word-level kernels over packed satisfaction vectors (see satisfaction.hh).
+ * Every kernel treats positions past the end of its operands as absent, which
+ * gives the truncated trace semantics of ASTNode::evaluate_subt.
+ */
+
+/* Sliding window max/min. Bit i of window_any is set iff i + lb < n and any
+ * bit of operand in [i+lb, min(i+ub, n-1)] is set, which is the satisfaction
+ * vector of F[lb,ub]. Bit i of window_all is set iff i + lb >= n or every bit
+ * in that window is set, the satisfaction vector of G[lb,ub].
+ *
+ * Both run in O(n/64 * log((ub-lb+1)/64)) word operations: windows up to one
+ * word wide are folded in registers in a single pass, wider windows are then
+ * covered by doubling shift-or passes over memory.
+ */
+BitVector window_any(const BitVector &operand, size_t lb, size_t ub);
+BitVector window_all(const BitVector &operand, size_t lb, size_t ub);
+
+/* Satisfaction vectors of left U[lb,ub] right and left R[lb,ub] right, which
+ * must have the same size. Like the windows above they are built by doubling,
+ * in O(n/64 * log(ub-lb+1)) word operations.
+ */
+BitVector window_until(const BitVector &left, const BitVector &right,
+                       size_t lb, size_t ub);
+BitVector window_release(const BitVector &left, const BitVector &right,
+                         size_t lb, size_t ub);
+
+/* Raw-word versions of the window kernels over n bits stored in (n+63)/64
+ * words. The padding bits of the operands must be zero and are zero in dst.
+ * window_any and window_all may be called with dst aliasing the operand,
+ * window_until and window_release may not.
+ */
+void window_any(uint64_t *dst, const uint64_t *src, size_t n, size_t lb,
+                size_t ub);
+void window_all(uint64_t *dst, const uint64_t *src, size_t n, size_t lb,
+                size_t ub);
+void window_until(uint64_t *dst, const uint64_t *left, const uint64_t *right,
+                  size_t n, size_t lb, size_t ub);
+void window_release(uint64_t *dst, const uint64_t *left, const uint64_t *right,
+                    size_t n, size_t lb, size_t ub);
+
+/* Fused kernels for nested windows: F[lb1,ub1] G[lb2,ub2] operand,
+ * G[lb1,ub1] F[lb2,ub2] operand and left U[lb1,ub1] (mid U[lb2,ub2] right).
+ * The result is that of the two window kernels one after the other, but the
+ * inner window is only ever computed for one cache-sized tile of the trace
+ * (plus the ub1 positions after it that the outer window reads), and the
+ * outer window is applied to it while it is still in cache. Every vector has
+ * n bits, as above.
+ */
+void window_any_all(uint64_t *dst, const uint64_t *src, size_t n, size_t lb1,
+                    size_t ub1, size_t lb2, size_t ub2);
+void window_all_any(uint64_t *dst, const uint64_t *src, size_t n, size_t lb1,
+                    size_t ub1, size_t lb2, size_t ub2);
+void window_until_until(uint64_t *dst, const uint64_t *left,
+                        const uint64_t *mid, const uint64_t *right, size_t n,
+                        size_t lb1, size_t ub1, size_t lb2, size_t ub2);
+BitVector window_any_all(const BitVector &operand, size_t lb1, size_t ub1,
+                         size_t lb2, size_t ub2);
+BitVector window_all_any(const BitVector &operand, size_t lb1, size_t ub1,
+                         size_t lb2, size_t ub2);
+BitVector window_until_until(const BitVector &left, const BitVector &mid,
+                             const BitVector &right, size_t lb1, size_t ub1,
+                             size_t lb2, size_t ub2);
+
+/* Bulk propositional kernels. Each computes num_words words of
+ * dst = op(a, b) (or dst = ~a) and may be called with dst aliasing an operand.
+ * They are vectorised with AVX-512 or AVX2 when the CPU supports it, with a
+ * portable scalar fallback. Padding bits past the logical end of a vector are
+ * not cleared; the BitVector overloads below take care of that.
+ */
+void bitwise_not(uint64_t *dst, const uint64_t *a, size_t num_words);
+void bitwise_and(uint64_t *dst, const uint64_t *a, const uint64_t *b,
+                 size_t num_words);
+void bitwise_or(uint64_t *dst, const uint64_t *a, const uint64_t *b,
+                size_t num_words);
+void bitwise_xor(uint64_t *dst, const uint64_t *a, const uint64_t *b,
+                 size_t num_words);
+void bitwise_implies(uint64_t *dst, const uint64_t *a, const uint64_t *b,
+                     size_t num_words);
+void bitwise_equiv(uint64_t *dst, const uint64_t *a, const uint64_t *b,
+                   size_t num_words);
+
+/* Satisfaction vectors of ~, &, |, ^, -> and <-> from those of the operands,
+ * which must have the same size.
+ */
+BitVector bitwise_not(const BitVector &a);
+BitVector bitwise_and(const BitVector &a, const BitVector &b);
+BitVector bitwise_or(const BitVector &a, const BitVector &b);
+BitVector bitwise_xor(const BitVector &a, const BitVector &b);
+BitVector bitwise_implies(const BitVector &a, const BitVector &b);
+BitVector bitwise_equiv(const BitVector &a, const BitVector &b);
+
+/* Instruction set used by the bulk kernels. The default is the widest one the
+ * CPU supports; set_simd_level clamps requests to what is supported and is
+ * mainly useful for benchmarking the fallbacks. It is safe to call while
+ * other threads run kernels, which pick up the new level on their next call.
+ */
+enum class SimdLevel { Scalar, AVX2, AVX512 };
+SimdLevel get_simd_level();
+void set_simd_level(SimdLevel level);
+
+} // namespace libmltl
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <unordered_map>
+
+#include "ast.hh"
+
+namespace libmltl {
+
+/* A trace together with a cache of evaluate_subt results, the input of the
+ * memoizing evaluation mode (ASTNode::evaluate_memoized).
+ *
+ * Every distinct node of the formula gets a dense index on construction, and
+ * the result of node.evaluate_subt(trace, begin, end) is stored at
+ * [index][begin] the first time it is computed. Nested temporal operators
+ * (F[..]G[..], chains of U) evaluate their operands over overlapping windows,
+ * which without the cache multiplies the work of every nesting level.
+ *
+ * The cache holds results for the end given on construction only; calls with
+ * another end, or on nodes that are not part of the formula, bypass it.
+ */
+class MemoTrace {
+private:
+  const Trace &trace;
+  size_t end;
+  std::unordered_map<const ASTNode *, size_t> index;
+  // 0: not computed yet, 1: false, 2: true. Filled in through const
+  // references, as evaluate_subt takes its trace by const reference.
+  mutable std::vector<uint8_t> cache;
+
+  void add_node(const ASTNode &node);
+
+public:
+  MemoTrace(const ASTNode &formula, const Trace &trace, size_t end);
+
+  const Trace &get_trace() const { return trace; }
+  size_t size() const { return trace.size(); }
+  /* Number of distinct nodes with a row in the cache.
+   */
+  size_t num_nodes() const { return index.size(); }
+
+  /* Returns the cached result of node.evaluate_subt(*this, begin, end), or
+   * computes it with compute() and caches it.
+   */
+  template <typename F>
+  bool memoize(const ASTNode &node, size_t begin, size_t end,
+               F compute) const {
+    if (end != this->end || begin >= end) {
+      return compute();
+    }
+    auto it = index.find(&node);
+    if (it == index.end()) {
+      return compute();
+    }
+    uint8_t &entry = cache[it->second * end + begin];
+    if (entry == 0) {
+      entry = compute() ? 2 : 1;
+    }
+    return entry == 2;
+  }
+};
+
+} // namespace libmltl
@@ -0,0 +1,124 @@
+#pragma once
+
+#include <optional>
+
+#include "ast.hh"
+#include "truth_table.hh"
+
+namespace libmltl {
+
+/* Online evaluation of a formula over a trace that arrives one state at a
+ * time.
+ *
+ * The verdict for time step t, evaluate_subt(trace, t, end), is the same for
+ * every end >= t + evaluation_reach(formula) (see satisfaction.hh), so it is
+ * final as soon as state t + delay() has arrived, where
+ *   delay() = max(1, evaluation_reach(formula)) - 1
+ * and push() returns it then.
+ *
+ * Every subformula produces one verdict per pushed state, delayed by its own
+ * delay. Temporal operators keep the positions inside their window at which
+ * an operand decides the verdict (e.g. where the operand of F holds) in a
+ * queue that is appended to and consumed from the front once, so a push costs
+ * amortized constant time per node regardless of the length of the trace, and
+ * history is never scanned again. Memory is bounded by the bounds of the
+ * formula: besides those queues, only the last delay() states are kept, to
+ * evaluate the time steps that are cut short when the trace ends (see
+ * truncated_verdicts).
+ *
+ * Maximal subformulas without temporal operators over at most
+ * TruthTable::max_vars variables are replaced by their truth table, so they
+ * cost one lookup per state instead of one node per operator.
+ */
+class Monitor {
+private:
+  /* Fixed capacity FIFO of time steps, stored in Monitor::buffer. The
+   * capacity is a power of two, mask is one less.
+   */
+  struct Queue {
+    size_t offset, mask;
+    size_t head, count;
+  };
+  struct Node {
+    ASTNode::Type type;
+    // operands, npos if there are none; F and G store theirs in right
+    size_t left, right;
+    // bounds of temporal operators, value of constants, id of variables
+    size_t lb, ub;
+    size_t delay;
+    // verdict for time step t at buffer[history + (t & history_mask)]
+    size_t history, history_mask;
+    // time steps where right (or left) decides the verdict, see monitor.cc
+    Queue left_events, right_events;
+    // index into tables if the node is tabulated, npos otherwise
+    size_t table;
+  };
+
+  std::shared_ptr<ASTNode> formula;
+  // operands before the nodes that use them, the root is last
+  std::vector<Node> nodes;
+  std::vector<TruthTable> tables;
+  // verdict histories and event queues of all nodes
+  std::vector<size_t> buffer;
+  size_t num_vars;
+  size_t len;
+  // the last delay() states (or more), state t at
+  // states[t & (states.size() - 1)]
+  std::vector<std::string> states;
+
+  size_t compile(const ASTNode &formula);
+  bool value(const Node &node, size_t t) const {
+    return buffer[node.history + (t & node.history_mask)];
+  }
+  void push_event(Queue &queue, size_t t) {
+    buffer[queue.offset + ((queue.head + queue.count++) & queue.mask)] = t;
+  }
+  /* Drops the time steps before begin and returns the first remaining one,
+   * npos if there is none.
+   */
+  size_t first_event(Queue &queue, size_t begin) {
+    while (queue.count > 0) {
+      size_t t = buffer[queue.offset + queue.head];
+      if (t >= begin) {
+        return t;
+      }
+      queue.head = (queue.head + 1) & queue.mask;
+      --queue.count;
+    }
+    return npos;
+  }
+
+public:
+  static constexpr size_t npos = (size_t)-1;
+
+  explicit Monitor(const ASTNode &formula);
+
+  /* Appends the next state of the trace, a string of 0s and 1s. The first
+   * state determines the number of variables; characters past it are ignored
+   * and missing characters read as 0, like for Trace.
+   *
+   * Returns the verdict for time step size() - 1 - delay() once it is final,
+   * otherwise (for the first delay() states) nothing.
+   */
+  std::optional<bool> push(const std::string &state);
+  /* Verdicts of the time steps that are not final yet, num_verdicts() to
+   * size() - 1, if the trace ended now (with the truncated trace semantics
+   * of evaluate_subt).
+   */
+  BitVector truncated_verdicts() const;
+  /* Starts a new trace.
+   */
+  void reset();
+
+  /* Number of states pushed.
+   */
+  size_t size() const { return len; }
+  /* Number of final verdicts returned by push.
+   */
+  size_t num_verdicts() const { return len - std::min(len, delay()); }
+  /* Number of states after time step t until its verdict is final.
+   */
+  size_t delay() const { return nodes.back().delay; }
+};
+
+} // namespace libmltl
@@ -1,6 +1,8 @@
 #pragma once
 
+#include "arena.hh"
 #include "ast.hh"
+#include "factory.hh"
 
 namespace libmltl {
 
@@ -19,8 +21,20 @@ public:
  * On an invalid MLTL formula, program will exit and print syntax error.
  */
 std::shared_ptr<ASTNode> parse(const std::string &formula);
+/* Like parse, but makes the nodes in arena. The result is valid for as long
+ * as the nodes of arena are (see arena.hh).
+ */
+std::shared_ptr<ASTNode> parse(const std::string &formula, ASTArena &arena);
+/* Like parse, but makes the nodes through factory, so that the result and
+ * its subformulas are interned (see factory.hh).
+ */
+std::shared_ptr<ASTNode> parse(const std::string &formula,
+                               FormulaFactory &factory);
 
-/* Reads a trace from file.
+/* Reads a trace from file. The result type may be the string form
+ * (std::vector<std::string>, the default), the bit-packed Trace, e.g.
+ * read_trace_file<Trace>(path), the run-length encoded IntervalTrace or the
+ * DictionaryTrace.
  *
  * Expected file format:
  *   Each line consists of comma separated 0/1's representing the truth value of
@@ -36,12 +50,13 @@ std::shared_ptr<ASTNode> parse(const std::string &formula);
  *
  *     Returns {"011","111","010","011"."000"}
  */
-std::vector<std::string> read_trace_file(const std::string &trace_file_path);
+template <typename T = std::vector<std::string>>
+T read_trace_file(const std::string &trace_file_path);
 
 /* Reads all files in a directory and parses them as traces.
  */
-std::vector<std::vector<std::string>>
-read_trace_files(const std::string &trace_directory_path);
+template <typename T = std::vector<std::string>>
+std::vector<T> read_trace_files(const std::string &trace_directory_path);
 
 /* Takes an integer and returns a string of 0s and 1s corresponding to the
  * binary value of n. The string will be zero left-padded or truncated to
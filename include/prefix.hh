@@ -0,0 +1,56 @@
+#pragma once
+
+#include "ast.hh"
+
+namespace libmltl {
+
+/* Evaluation of a formula over a trace that may not be complete yet.
+ *
+ * ASTNode::evaluate treats the trace as the whole mission. Here it is a
+ * prefix that may be continued by any number of further states (including
+ * none), and a verdict is only decided if every such continuation agrees on
+ * it. G[0,1000](p0) is decided false as soon as p0 does not hold, and
+ * F[0,1000](p0) true as soon as it does, while everything else is unknown
+ * until the whole window has been seen.
+ *
+ * Verdicts are computed bottom-up like evaluate_all, with the subformulas
+ * combined in Kleene's three-valued logic. This is sound (a decided verdict
+ * is the one of every continuation) and decides every verdict whose window
+ * lies within the prefix, i.e. from evaluation_reach states on, but it may
+ * report unknown for verdicts that only contradictory or redundant
+ * subformulas decide earlier, e.g. G[0,5](p0) | F[0,5](~p0).
+ */
+enum class Verdict { False, True, Unknown };
+
+/* Three-valued satisfaction vectors over the time steps of a prefix.
+ */
+struct PrefixSatisfaction {
+  // bit i is set iff every continuation satisfies (violates) the formula at
+  // time step i
+  BitVector is_true, is_false;
+  // the same for every time step past the prefix that a continuation has
+  bool beyond_true, beyond_false;
+
+  size_t size() const { return is_true.size(); }
+  Verdict get(size_t i) const {
+    return is_true[i] ? Verdict::True
+                      : (is_false[i] ? Verdict::False : Verdict::Unknown);
+  }
+};
+
+PrefixSatisfaction evaluate_prefix_all(const ASTNode &formula,
+                                       const Trace &prefix);
+/* Verdict of formula.evaluate on every continuation of prefix.
+ */
+Verdict evaluate_prefix(const ASTNode &formula, const Trace &prefix);
+Verdict evaluate_prefix(const ASTNode &formula,
+                        const std::vector<std::string> &prefix);
+/* Length of the shortest prefix of trace that decides the verdict, so the
+ * earliest decided time step is one less and no state after it needs to be
+ * read. 0 if no state is needed and (size_t)-1 if trace does not decide it.
+ */
+size_t decision_length(const ASTNode &formula, const Trace &trace);
+size_t decision_length(const ASTNode &formula,
+                       const std::vector<std::string> &trace);
+
+} // namespace libmltl
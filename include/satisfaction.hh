@@ -0,0 +1,102 @@
+#pragma once
+
+#include "ast.hh"
+#include "thread_pool.hh"
+
+#include <array>
+#include <map>
+#include <unordered_map>
+
+namespace libmltl {
+
+/* Bottom-up evaluation engine.
+ *
+ * Instead of recursively re-evaluating operands at every index of a temporal
+ * window (like ASTNode::evaluate_subt), the satisfaction vector of every
+ * subformula is computed over all start positions in one post-order pass. Bit
+ * i of the returned vector is set iff
+ *   formula.evaluate_subt(trace, i, trace.size())
+ * holds, including the truncated trace semantics near the end of the trace.
+ * Bit 0 is therefore the verdict of formula.evaluate(trace).
+ *
+ * F directly over G, G directly over F and U with a U as right operand are
+ * evaluated with the fused kernels of kernels.hh, without the satisfaction
+ * vector of the inner operator.
+ */
+BitVector evaluate_all(const ASTNode &formula, const Trace &trace);
+BitVector evaluate_all(const ASTNode &formula,
+                       const std::vector<std::string> &trace);
+/* Same as evaluate_all over the dictionary encoded form of trace. Subformulas
+ * without temporal operators are evaluated once per distinct state and
+ * expanded to the time steps through the ids, the temporal operators above
+ * them as usual.
+ */
+BitVector evaluate_all(const ASTNode &formula, const DictionaryTrace &trace);
+/* Same as evaluate_all, for a single long trace, with the time steps split
+ * into chunks of chunk_size (rounded up to a multiple of 64, 0 chooses a few
+ * chunks per thread) that are evaluated in parallel on pool, or on
+ * num_threads new threads (0 means one per hardware thread).
+ *
+ * The verdicts at [begin, end) are decided by the states
+ * [begin, end - 1 + evaluation_reach(formula)), so every chunk is evaluated
+ * over evaluation_reach(formula) - 1 states past its end, and the result is
+ * identical to the sequential one.
+ */
+BitVector evaluate_all(const ASTNode &formula, const Trace &trace,
+                       ThreadPool &pool, size_t chunk_size = 0);
+BitVector evaluate_all(const ASTNode &formula, const Trace &trace,
+                       unsigned int num_threads, size_t chunk_size = 0);
+
+/* Number of states, counted from a start position i, that decide the verdict
+ * at i: evaluate_subt(trace, i, end) is the same for every
+ * end >= i + evaluation_reach(formula). This equals future_reach() unless a
+ * temporal operator ranges over a subformula without variables, where it can
+ * be one more (F[2,2](true) holds on traces of length 3 but not 2, yet has a
+ * future reach of 2).
+ */
+size_t evaluation_reach(const ASTNode &formula);
+
+/* Evaluates a set of formulas together. Subformulas that are shared (the same
+ * node) or structurally identical (equal operators, bounds and operands) are
+ * merged into one node of a DAG when the context is built, and each distinct
+ * node is then evaluated once per trace with the bottom-up engine, over only
+ * the prefix of the trace that can decide any of the verdicts.
+ *
+ * The context keeps the formulas alive but assumes they are not modified
+ * afterwards.
+ */
+class EvaluationContext {
+private:
+  struct Node {
+    const ASTNode *formula;
+    // indices of the operands in nodes, npos if there are none
+    size_t left, right;
+  };
+  typedef std::array<size_t, 5> NodeKey;
+
+  std::vector<std::shared_ptr<ASTNode>> formulas;
+  // distinct subformulas, operands before the nodes that use them
+  std::vector<Node> nodes;
+  std::vector<size_t> roots;
+  size_t reach;
+
+  size_t add_node(const ASTNode &formula, std::map<NodeKey, size_t> &index,
+                  std::unordered_map<const ASTNode *, size_t> &seen);
+
+public:
+  static constexpr size_t npos = (size_t)-1;
+
+  explicit EvaluationContext(
+      const std::vector<std::shared_ptr<ASTNode>> &formulas);
+
+  size_t num_formulas() const { return roots.size(); }
+  /* Number of distinct subformulas over all formulas.
+   */
+  size_t num_nodes() const { return nodes.size(); }
+  /* Bit k of the result is formulas[k]->evaluate(trace).
+   */
+  BitVector evaluate(const Trace &trace) const;
+  BitVector evaluate(const std::vector<std::string> &trace) const;
+};
+
+} // namespace libmltl
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <functional>
+#include <istream>
+#include <ostream>
+
+#include "ast.hh"
+
+namespace libmltl {
+
+/* Evaluation of traces that are too long to be loaded, read from a stream in
+ * the format of read_trace_file.
+ *
+ * The states are read into a window of a fixed number of time steps plus the
+ * evaluation_reach(formula) - 1 following ones, which decide the verdicts in
+ * the window (see satisfaction.hh). The window is evaluated with evaluate_all,
+ * its verdicts are passed on, and the lookahead is kept as the start of the
+ * next window. Memory use thus depends on the window size and the bounds of
+ * the formula, but not on the length of the trace.
+ */
+
+/* Receives the verdicts for time steps [begin, begin + verdicts.size()), in
+ * order.
+ */
+typedef std::function<void(size_t begin, const BitVector &verdicts)>
+    VerdictSink;
+
+struct StreamStats {
+  // states read
+  size_t steps;
+  double seconds;
+
+  double steps_per_second() const { return seconds > 0 ? steps / seconds : 0; }
+};
+
+/* Time steps per window unless the caller chooses: 2 MiB for each variable
+ * and for the satisfaction vector of each subformula.
+ */
+constexpr size_t default_stream_window = (size_t)1 << 24;
+
+/* Passes the verdict of every time step of trace to sink, in windows of
+ * window_size time steps (rounded up to a multiple of 64). The verdicts are
+ * those of evaluate_all over the whole trace.
+ */
+StreamStats evaluate_stream(const ASTNode &formula, std::istream &trace,
+                            const VerdictSink &sink,
+                            size_t window_size = default_stream_window);
+/* Passes only the verdict of formula.evaluate(trace) to sink, as one bit for
+ * time step 0. Reading stops after the evaluation_reach(formula) states that
+ * decide it.
+ */
+StreamStats evaluate_stream_final(const ASTNode &formula,
+                                  std::istream &trace,
+                                  const VerdictSink &sink);
+
+/* Evaluates the trace file at trace_file_path and writes the verdicts to out,
+ * one line of 0 or 1 per time step, or only the verdict at time step 0
+ * unless all_steps. Throws std::runtime_error if the file cannot be opened.
+ */
+StreamStats evaluate_trace_file(const ASTNode &formula,
+                                const std::string &trace_file_path,
+                                std::ostream &out, bool all_steps = true,
+                                size_t window_size = default_stream_window);
+
+} // namespace libmltl
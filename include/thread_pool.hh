@@ -0,0 +1,73 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace libmltl {
+
+/* A fixed set of threads that run the tasks 0, ..., num_tasks - 1 of one
+ * parallel loop at a time.
+ *
+ * Every thread starts with a contiguous range of the tasks and runs them in
+ * order. A thread that has run out steals the upper half of the remaining
+ * range of another thread, so neighbouring tasks (e.g. tiles that share their
+ * input) tend to run on the same thread while the load stays balanced.
+ */
+class ThreadPool {
+private:
+  /* Tasks [begin, end) not started yet by one thread.
+   */
+  struct Range {
+    std::mutex mutex;
+    size_t begin, end;
+  };
+
+  std::vector<std::thread> threads;
+  // one per thread, the calling thread of run() is number 0
+  std::unique_ptr<Range[]> ranges;
+
+  // held for the whole of run(), so concurrent loops run one after the other
+  std::mutex run_mutex;
+  std::mutex state_mutex;
+  std::condition_variable start_cv, done_cv;
+  const std::function<void(size_t)> *task;
+  size_t generation;
+  size_t active;
+  bool stop;
+  // the first exception thrown by a task of the current loop
+  std::exception_ptr error;
+  std::atomic<bool> cancelled;
+
+  void worker(size_t self);
+  bool next_task(size_t self, size_t &t);
+  void work(size_t self);
+
+public:
+  /* Runs loops on num_threads threads, including the one calling run(). 0
+   * means std::thread::hardware_concurrency().
+   */
+  explicit ThreadPool(unsigned int num_threads = 0);
+  ~ThreadPool();
+  ThreadPool(const ThreadPool &) = delete;
+  ThreadPool &operator=(const ThreadPool &) = delete;
+
+  /* Calls task(t) for every t in [0, num_tasks) and returns once all calls
+   * have returned. If a task throws, no further tasks are started and the
+   * exception is rethrown.
+   *
+   * Calls from several threads are serialised. A task must not call run() on
+   * the pool that runs it, which would wait for itself; this throws
+   * std::logic_error instead.
+   */
+  void run(size_t num_tasks, const std::function<void(size_t)> &task);
+
+  size_t size() const { return threads.size() + 1; }
+};
+
+} // namespace libmltl
@@ -0,0 +1,156 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace libmltl {
+
+/* Fixed length sequence of bits packed into 64-bit words. Bit i is stored in
+ * bit (i % 64) of word (i / 64). Bits past size() in the last word are always
+ * kept zero, so whole words can be compared, counted and combined directly.
+ */
+class BitVector {
+private:
+  size_t len;
+  std::vector<uint64_t> words;
+
+public:
+  BitVector();
+  BitVector(size_t length, bool value = false);
+
+  size_t size() const { return len; }
+  size_t num_words() const { return words.size(); }
+  uint64_t *data() { return words.data(); }
+  const uint64_t *data() const { return words.data(); }
+  bool get(size_t i) const { return (words[i >> 6] >> (i & 63)) & 1; }
+  bool operator[](size_t i) const { return get(i); }
+  void set(size_t i, bool value) {
+    if (value) {
+      words[i >> 6] |= (uint64_t)1 << (i & 63);
+    } else {
+      words[i >> 6] &= ~((uint64_t)1 << (i & 63));
+    }
+  }
+
+  void push_back(bool value);
+  void resize(size_t length, bool value = false);
+  /* Returns bits [begin, end).
+   */
+  BitVector slice(size_t begin, size_t end) const;
+  /* Zeros the bits past size() in the last word. Must be called after writing
+   * whole words through data().
+   */
+  void clear_padding();
+  /* Returns the number of set bits.
+   */
+  size_t count() const;
+  /* Returns the index of the first set (or unset) bit at or after pos, or
+   * size() if there is none.
+   */
+  size_t find_next(size_t pos) const;
+  size_t find_next_unset(size_t pos) const;
+  /* Returns a string of 0s and 1s, index 0 first.
+   */
+  std::string as_string() const;
+  bool operator==(const BitVector &other) const;
+  bool operator!=(const BitVector &other) const { return !(*this == other); }
+};
+
+/* Bit-packed, columnar trace. Each propositional variable is stored as its own
+ * BitVector over time, so a trace of n time steps over m variables occupies
+ * about m * n / 8 bytes instead of n heap allocated strings of m characters.
+ *
+ * A Trace built from the string form behaves identically under evaluation:
+ * the number of variables is taken from the first state, characters past it
+ * are ignored and missing characters read as 0.
+ */
+class Trace {
+private:
+  size_t len;
+  std::vector<BitVector> columns;
+
+public:
+  Trace();
+  Trace(size_t num_vars, size_t length);
+  explicit Trace(const std::vector<std::string> &trace);
+
+  size_t size() const { return len; }
+  size_t num_vars() const { return columns.size(); }
+  bool get(unsigned int id, size_t t) const {
+    return id < columns.size() && columns[id].get(t);
+  }
+  void set(unsigned int id, size_t t, bool value) {
+    columns[id].set(t, value);
+  }
+  const BitVector &get_variable(unsigned int id) const { return columns[id]; }
+  BitVector &get_variable(unsigned int id) { return columns[id]; }
+
+  /* Appends a state given as a string of 0s and 1s. The first state appended
+   * to an empty trace with no variables determines num_vars().
+   */
+  void push_back(const std::string &state);
+  /* Returns time steps [begin, end), with the same variables.
+   */
+  Trace slice(size_t begin, size_t end) const;
+  std::string get_state(size_t t) const;
+  std::vector<std::string> as_strings() const;
+};
+
+/* Dictionary encoded trace. Every distinct state is stored once, as a time
+ * step of the Trace get_states(), and the trace is the sequence of their ids,
+ * one byte per time step while there are at most 256 distinct states and two
+ * up to 65536 (four past that). With few variables most of a long trace
+ * repeats a handful of states.
+ *
+ * The states are normalised like in Trace: the number of variables is taken
+ * from the first state, characters past it are ignored and missing
+ * characters read as 0.
+ */
+class DictionaryTrace {
+private:
+  size_t len;
+  // the ids in the narrowest of these that fits num_states()
+  std::vector<uint8_t> ids8;
+  std::vector<uint16_t> ids16;
+  std::vector<uint32_t> ids32;
+  Trace states;
+  std::unordered_map<std::string, uint32_t> index;
+
+public:
+  DictionaryTrace();
+  explicit DictionaryTrace(const std::vector<std::string> &trace);
+  explicit DictionaryTrace(const Trace &trace);
+
+  size_t size() const { return len; }
+  size_t num_vars() const { return states.num_vars(); }
+  size_t num_states() const { return states.size(); }
+  /* Bytes per id, 1, 2 or 4.
+   */
+  size_t id_width() const {
+    return num_states() <= 256 ? 1 : (num_states() <= 65536 ? 2 : 4);
+  }
+  size_t get_id(size_t t) const {
+    return !ids8.empty() ? ids8[t] : (!ids16.empty() ? ids16[t] : ids32[t]);
+  }
+  const std::vector<uint8_t> &get_ids8() const { return ids8; }
+  const std::vector<uint16_t> &get_ids16() const { return ids16; }
+  const std::vector<uint32_t> &get_ids32() const { return ids32; }
+  /* The distinct states, state k at time step k.
+   */
+  const Trace &get_states() const { return states; }
+  bool get(unsigned int id, size_t t) const {
+    return states.get(id, get_id(t));
+  }
+
+  /* Appends a state given as a string of 0s and 1s. The first state appended
+   * determines num_vars().
+   */
+  void push_back(const std::string &state);
+  std::string get_state(size_t t) const { return states.get_state(get_id(t)); }
+  std::vector<std::string> as_strings() const;
+  Trace to_trace() const;
+};
+
+} // namespace libmltl
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <algorithm>
+
+#include "ast.hh"
+
+namespace libmltl {
+
+/* Precomputed value of a formula without temporal operators for every
+ * assignment of its variables. Its value at a state is then one lookup at the
+ * index packed from the bits of those variables, instead of one step per
+ * operator.
+ */
+class TruthTable {
+private:
+  // bit k of an index is the value of variable vars[k], in increasing order
+  std::vector<unsigned int> vars;
+  // the value of the formula for every index
+  BitVector table;
+
+public:
+  static constexpr size_t max_vars = 16;
+
+  TruthTable();
+  /* Tabulates formula, which must satisfy is_tabulable. The table is filled
+   * by one evaluate_all over a trace that enumerates the 2^num_vars()
+   * assignments.
+   */
+  explicit TruthTable(const ASTNode &formula);
+
+  const std::vector<unsigned int> &get_vars() const { return vars; }
+  size_t num_vars() const { return vars.size(); }
+  bool lookup(size_t index) const { return table[index]; }
+  /* Value of the formula at state, a string of 0s and 1s in which variables
+   * past num_state_vars (or past its end) read as 0, like in Monitor::push.
+   */
+  bool evaluate(const std::string &state, size_t num_state_vars) const {
+    size_t index = 0;
+    size_t width = std::min(num_state_vars, state.size());
+    for (size_t k = 0; k < vars.size(); ++k) {
+      index |= (size_t)(vars[k] < width && state[vars[k]] == '1') << k;
+    }
+    return table[index];
+  }
+};
+
+/* Returns whether formula has no temporal operators and at most
+ * TruthTable::max_vars distinct variables.
+ */
+bool is_tabulable(const ASTNode &formula);
+
+} // namespace libmltl
@@ -0,0 +1,35 @@
+#include "arena.hh"
+#include "parser.hh"
+
+using namespace std;
+namespace libmltl {
+
+ASTArena::ASTArena() : used(slab_size), num_nodes(0) {}
+
+void *ASTArena::allocate(size_t size, size_t alignment) {
+  size_t offset = (used + alignment - 1) & ~(alignment - 1);
+  if (slabs.empty() || offset + size > slab_size) {
+    // new[] aligns for any fundamental type, which covers every node
+    slabs.emplace_back(new unsigned char[slab_size]);
+    offset = 0;
+  }
+  used = offset + size;
+  return slabs.back().get() + offset;
+}
+
+void ASTArena::clear() {
+  // nodes only refer to each other, so they are dropped with their slabs
+  if (slabs.size() > 1) {
+    slabs.resize(1);
+  }
+  used = 0;
+  num_nodes = 0;
+}
+
+UniqueFormula::UniqueFormula() {}
+UniqueFormula::UniqueFormula(const ASTNode &formula)
+    : arena(new ASTArena()), root(formula.deep_copy(*arena)) {}
+UniqueFormula::UniqueFormula(const string &formula)
+    : arena(new ASTArena()), root(parse(formula, *arena)) {}
+
+} // namespace libmltl
@@ -1,9 +1,19 @@
 #include "ast.hh"
+#include "arena.hh"
+#include "memo.hh"
 
 using namespace std;
 namespace libmltl {
 
-Constant::Constant(bool value) : val(value) {}
+/* Negative, zero or positive as a is less than, equal to or greater than b.
+ */
+template <typename T> int compare_values(const T &a, const T &b) {
+  return (a > b) - (a < b);
+}
+
+Constant::Constant(bool value) : val(value) { update_hash(); }
+
+void Constant::update_hash() { hash_value = val; }
 
 ASTNode::Type Constant::get_type() const { return ASTNode::Type::Constant; }
 bool Constant::is_unary_op() const { return false; }
@@ -18,35 +28,39 @@ bool Constant::evaluate_subt(
     [[maybe_unused]] size_t begin, [[maybe_unused]] size_t end) const {
   return val;
 }
+bool Constant::evaluate_subt([[maybe_unused]] const Trace &trace,
+                             [[maybe_unused]] size_t begin,
+                             [[maybe_unused]] size_t end) const {
+  return val;
+}
+bool Constant::evaluate_subt([[maybe_unused]] const MemoTrace &trace,
+                             [[maybe_unused]] size_t begin,
+                             [[maybe_unused]] size_t end) const {
+  return val;
+}
 size_t Constant::future_reach() const { return 0; }
 size_t Constant::size() const { return 1; }
 size_t Constant::depth() const { return 0; }
 size_t Constant::count(ASTNode::Type target_type) const {
   return (get_type() == target_type);
 }
+void Constant::rehash() { update_hash(); }
 std::shared_ptr<ASTNode> Constant::deep_copy() const {
   return std::make_shared<Constant>(val);
 }
-bool Constant::operator==(const ASTNode &other) const {
-  return ((get_type() == other.get_type()) &&
-          (val == static_cast<const Constant &>(other).val));
+std::shared_ptr<ASTNode> Constant::deep_copy(ASTArena &arena) const {
+  return arena.make<Constant>(val);
 }
-bool Constant::operator<(const ASTNode &other) const {
+int Constant::compare(const ASTNode &other) const {
   if (get_type() != other.get_type()) {
-    return (get_type() < other.get_type());
-  } else {
-    return (val < static_cast<const Constant &>(other).val);
-  }
-}
-bool Constant::operator<=(const ASTNode &other) const {
-  if (get_type() != other.get_type()) {
-    return (get_type() <= other.get_type());
-  } else {
-    return (val <= static_cast<const Constant &>(other).val);
+    return compare_values(get_type(), other.get_type());
   }
+  return compare_values(val, static_cast<const Constant &>(other).val);
 }
 
-Variable::Variable(unsigned int id) : id(id) {}
+Variable::Variable(unsigned int id) : id(id) { update_hash(); }
+
+void Variable::update_hash() { hash_value = id; }
 
 ASTNode::Type Variable::get_type() const { return ASTNode::Type::Variable; }
 bool Variable::is_unary_op() const { return false; }
@@ -63,37 +77,50 @@ bool Variable::evaluate_subt(const std::vector<std::string> &trace,
   }
   return (trace[begin][id] == '1');
 }
+bool Variable::evaluate_subt(const Trace &trace, size_t begin,
+                             size_t end) const {
+  if (begin == end) {
+    return false;
+  }
+  return trace.get(id, begin);
+}
+bool Variable::evaluate_subt(const MemoTrace &trace, size_t begin,
+                             size_t end) const {
+  return evaluate_subt(trace.get_trace(), begin, end);
+}
 size_t Variable::future_reach() const { return 1; }
 size_t Variable::size() const { return 1; }
 size_t Variable::depth() const { return 0; }
 size_t Variable::count(ASTNode::Type target_type) const {
   return (get_type() == target_type);
 }
+void Variable::rehash() { update_hash(); }
 std::shared_ptr<ASTNode> Variable::deep_copy() const {
   return std::make_shared<Variable>(id);
 }
-bool Variable::operator==(const ASTNode &other) const {
-  return ((get_type() == other.get_type()) &&
-          (id == static_cast<const Variable &>(other).id));
+std::shared_ptr<ASTNode> Variable::deep_copy(ASTArena &arena) const {
+  return arena.make<Variable>(id);
 }
-bool Variable::operator<(const ASTNode &other) const {
+int Variable::compare(const ASTNode &other) const {
   if (get_type() != other.get_type()) {
-    return (get_type() < other.get_type());
-  } else {
-    return (id < static_cast<const Variable &>(other).id);
-  }
-}
-bool Variable::operator<=(const ASTNode &other) const {
-  if (get_type() != other.get_type()) {
-    return (get_type() <= other.get_type());
-  } else {
-    return (id <= static_cast<const Variable &>(other).id);
+    return compare_values(get_type(), other.get_type());
   }
+  return compare_values(id, static_cast<const Variable &>(other).id);
 }
 
 UnaryOp::UnaryOp() : operand(nullptr) {}
 UnaryOp::UnaryOp(std::shared_ptr<ASTNode> operand)
-    : operand(std::move(operand)) {}
+    : operand(std::move(operand)) {
+  update_hash();
+}
+
+void UnaryOp::update_hash() { hash_value = operand ? operand->hash() : 0; }
+void UnaryOp::rehash() {
+  if (operand) {
+    operand->rehash();
+  }
+  update_hash();
+}
 
 bool UnaryOp::is_unary_op() const { return true; }
 bool UnaryOp::is_binary_op() const { return false; }
@@ -115,23 +142,14 @@ std::string UnaryPropOp::as_pretty_string() const {
   return get_symbol() + operand->as_pretty_string();
 }
 size_t UnaryPropOp::future_reach() const { return operand->future_reach(); }
-bool UnaryPropOp::operator==(const ASTNode &other) const {
-  return ((get_type() == other.get_type()) &&
-          (*operand == *static_cast<const UnaryPropOp &>(other).operand));
-}
-bool UnaryPropOp::operator<(const ASTNode &other) const {
-  if (get_type() != other.get_type()) {
-    return (get_type() < other.get_type());
-  } else {
-    return (*operand < *static_cast<const UnaryPropOp &>(other).operand);
-  }
-}
-bool UnaryPropOp::operator<=(const ASTNode &other) const {
-  if (get_type() != other.get_type()) {
-    return (get_type() <= other.get_type());
-  } else {
-    return (*operand <= *static_cast<const UnaryPropOp &>(other).operand);
+int UnaryPropOp::compare(const ASTNode &other) const {
+  // interned subformulas (see factory.hh) are compared by identity
+  if (this == &other) {
+    return 0;
+  } else if (get_type() != other.get_type()) {
+    return compare_values(get_type(), other.get_type());
   }
+  return operand->compare(*static_cast<const UnaryPropOp &>(other).operand);
 }
 
 ASTNode::Type Negation::get_type() const { return ASTNode::Type::Negation; }
@@ -140,13 +158,33 @@ bool Negation::evaluate_subt(const std::vector<std::string> &trace,
                              size_t begin, size_t end) const {
   return !operand->evaluate_subt(trace, begin, end);
 }
+bool Negation::evaluate_subt(const Trace &trace, size_t begin,
+                             size_t end) const {
+  return !operand->evaluate_subt(trace, begin, end);
+}
+bool Negation::evaluate_subt(const MemoTrace &trace, size_t begin,
+                             size_t end) const {
+  return trace.memoize(*this, begin, end, [&] {
+    return !operand->evaluate_subt(trace, begin, end);
+  });
+}
 std::shared_ptr<ASTNode> Negation::deep_copy() const {
   return std::make_shared<Negation>(operand->deep_copy());
 }
+std::shared_ptr<ASTNode> Negation::deep_copy(ASTArena &arena) const {
+  return arena.make<Negation>(operand->deep_copy(arena));
+}
 
 UnaryTempOp::UnaryTempOp() : UnaryOp(), lb(0), ub(0) {}
 UnaryTempOp::UnaryTempOp(std::shared_ptr<ASTNode> operand, size_t lb, size_t ub)
-    : UnaryOp(std::move(operand)), lb(lb), ub(ub) {}
+    : UnaryOp(std::move(operand)), lb(lb), ub(ub) {
+  update_hash();
+}
+
+void UnaryTempOp::update_hash() {
+  UnaryOp::update_hash();
+  hash_value = hash_combine(hash_combine(hash_value, lb), ub);
+}
 
 bool UnaryTempOp::is_propositional_op() const { return false; }
 bool UnaryTempOp::is_temporal_op() const { return true; }
@@ -165,39 +203,27 @@ std::string UnaryTempOp::as_pretty_string() const {
 size_t UnaryTempOp::future_reach() const {
   return ub + operand->future_reach();
 }
-bool UnaryTempOp::operator==(const ASTNode &other) const {
-  return ((get_type() == other.get_type()) &&
-          (*operand == *static_cast<const UnaryTempOp &>(other).operand) &&
-          (lb == static_cast<const UnaryTempOp &>(other).lb) &&
-          (ub == static_cast<const UnaryTempOp &>(other).ub));
-}
-bool UnaryTempOp::operator<(const ASTNode &other) const {
-  if (get_type() != other.get_type()) {
-    return (get_type() < other.get_type());
-  } else if (*operand != *static_cast<const UnaryTempOp &>(other).operand) {
-    return (*operand < *static_cast<const UnaryTempOp &>(other).operand);
-  } else if (lb != static_cast<const UnaryTempOp &>(other).lb) {
-    return (lb < static_cast<const UnaryTempOp &>(other).lb);
-  } else {
-    return (ub < static_cast<const UnaryTempOp &>(other).ub);
+int UnaryTempOp::compare(const ASTNode &other) const {
+  if (this == &other) {
+    return 0;
+  } else if (get_type() != other.get_type()) {
+    return compare_values(get_type(), other.get_type());
   }
-}
-bool UnaryTempOp::operator<=(const ASTNode &other) const {
-  if (get_type() != other.get_type()) {
-    return (get_type() <= other.get_type());
-  } else if (*operand != *static_cast<const UnaryTempOp &>(other).operand) {
-    return (*operand <= *static_cast<const UnaryTempOp &>(other).operand);
-  } else if (lb != static_cast<const UnaryTempOp &>(other).lb) {
-    return (lb <= static_cast<const UnaryTempOp &>(other).lb);
-  } else {
-    return (ub <= static_cast<const UnaryTempOp &>(other).ub);
+  const UnaryTempOp &op = static_cast<const UnaryTempOp &>(other);
+  if (int result = operand->compare(*op.operand)) {
+    return result;
+  } else if (lb != op.lb) {
+    return compare_values(lb, op.lb);
   }
+  return compare_values(ub, op.ub);
 }
 
-ASTNode::Type Finally::get_type() const { return ASTNode::Type::Finally; }
-std::string Finally::get_symbol() const { return "F"; }
-bool Finally::evaluate_subt(const vector<string> &trace, size_t begin,
-                            size_t end) const {
+/* The temporal operators share one implementation of evaluate_subt for every
+ * trace representation.
+ */
+template <typename T>
+bool finally_subt(const ASTNode &operand, size_t lb, size_t ub, const T &trace,
+                  size_t begin, size_t end) {
   size_t subt_len = end - begin;
   if (subt_len <= lb) {
     return false;
@@ -206,20 +232,39 @@ bool Finally::evaluate_subt(const vector<string> &trace, size_t begin,
   size_t idx_ub = begin + ub;
   size_t idx_end = min(idx_ub + 1, end);
   for (size_t i = idx_lb; i < idx_end; ++i) {
-    if (operand->evaluate_subt(trace, i, end)) {
+    if (operand.evaluate_subt(trace, i, end)) {
       return true;
     }
   }
   return false;
 }
+
+ASTNode::Type Finally::get_type() const { return ASTNode::Type::Finally; }
+std::string Finally::get_symbol() const { return "F"; }
+bool Finally::evaluate_subt(const vector<string> &trace, size_t begin,
+                            size_t end) const {
+  return finally_subt(*operand, lb, ub, trace, begin, end);
+}
+bool Finally::evaluate_subt(const Trace &trace, size_t begin,
+                            size_t end) const {
+  return finally_subt(*operand, lb, ub, trace, begin, end);
+}
+bool Finally::evaluate_subt(const MemoTrace &trace, size_t begin,
+                            size_t end) const {
+  return trace.memoize(*this, begin, end, [&] {
+    return finally_subt(*operand, lb, ub, trace, begin, end);
+  });
+}
 std::shared_ptr<ASTNode> Finally::deep_copy() const {
   return std::make_shared<Finally>(operand->deep_copy(), lb, ub);
 }
+std::shared_ptr<ASTNode> Finally::deep_copy(ASTArena &arena) const {
+  return arena.make<Finally>(operand->deep_copy(arena), lb, ub);
+}
 
-ASTNode::Type Globally::get_type() const { return ASTNode::Type::Globally; }
-std::string Globally::get_symbol() const { return "G"; }
-bool Globally::evaluate_subt(const vector<string> &trace, size_t begin,
-                             size_t end) const {
+template <typename T>
+bool globally_subt(const ASTNode &operand, size_t lb, size_t ub,
+                   const T &trace, size_t begin, size_t end) {
   size_t subt_len = end - begin;
   if (subt_len <= lb) {
     return true;
@@ -228,20 +273,55 @@ bool Globally::evaluate_subt(const vector<string> &trace, size_t begin,
   size_t idx_ub = begin + ub;
   size_t idx_end = min(idx_ub + 1, end);
   for (size_t i = idx_lb; i < idx_end; ++i) {
-    if (!operand->evaluate_subt(trace, i, end)) {
+    if (!operand.evaluate_subt(trace, i, end)) {
       return false;
     }
   }
   return true;
 }
+
+ASTNode::Type Globally::get_type() const { return ASTNode::Type::Globally; }
+std::string Globally::get_symbol() const { return "G"; }
+bool Globally::evaluate_subt(const vector<string> &trace, size_t begin,
+                             size_t end) const {
+  return globally_subt(*operand, lb, ub, trace, begin, end);
+}
+bool Globally::evaluate_subt(const Trace &trace, size_t begin,
+                             size_t end) const {
+  return globally_subt(*operand, lb, ub, trace, begin, end);
+}
+bool Globally::evaluate_subt(const MemoTrace &trace, size_t begin,
+                             size_t end) const {
+  return trace.memoize(*this, begin, end, [&] {
+    return globally_subt(*operand, lb, ub, trace, begin, end);
+  });
+}
 std::shared_ptr<ASTNode> Globally::deep_copy() const {
   return std::make_shared<Globally>(operand->deep_copy(), lb, ub);
 }
+std::shared_ptr<ASTNode> Globally::deep_copy(ASTArena &arena) const {
+  return arena.make<Globally>(operand->deep_copy(arena), lb, ub);
+}
 
 BinaryOp::BinaryOp() : left(nullptr), right(nullptr) {}
 BinaryOp::BinaryOp(std::shared_ptr<ASTNode> left,
                    std::shared_ptr<ASTNode> right)
-    : left(std::move(left)), right(std::move(right)) {}
+    : left(std::move(left)), right(std::move(right)) {
+  update_hash();
+}
+
+void BinaryOp::update_hash() {
+  hash_value = hash_combine(left ? left->hash() : 0, right ? right->hash() : 0);
+}
+void BinaryOp::rehash() {
+  if (left) {
+    left->rehash();
+  }
+  if (right) {
+    right->rehash();
+  }
+  update_hash();
+}
 
 bool BinaryOp::is_unary_op() const { return false; }
 bool BinaryOp::is_binary_op() const { return true; }
@@ -278,28 +358,17 @@ std::string BinaryPropOp::as_pretty_string() const {
 size_t BinaryPropOp::future_reach() const {
   return std::max(left->future_reach(), right->future_reach());
 }
-bool BinaryPropOp::operator==(const ASTNode &other) const {
-  return ((get_type() == other.get_type()) &&
-          (*left == *static_cast<const BinaryPropOp &>(other).left) &&
-          (*right == *static_cast<const BinaryPropOp &>(other).right));
-}
-bool BinaryPropOp::operator<(const ASTNode &other) const {
-  if (get_type() != other.get_type()) {
-    return (get_type() < other.get_type());
-  } else if (*left != *static_cast<const BinaryPropOp &>(other).left) {
-    return (*left < *static_cast<const BinaryPropOp &>(other).left);
-  } else {
-    return (*right < *static_cast<const BinaryPropOp &>(other).right);
+int BinaryPropOp::compare(const ASTNode &other) const {
+  if (this == &other) {
+    return 0;
+  } else if (get_type() != other.get_type()) {
+    return compare_values(get_type(), other.get_type());
   }
-}
-bool BinaryPropOp::operator<=(const ASTNode &other) const {
-  if (get_type() != other.get_type()) {
-    return (get_type() <= other.get_type());
-  } else if (*left != *static_cast<const BinaryPropOp &>(other).left) {
-    return (*left <= *static_cast<const BinaryPropOp &>(other).left);
-  } else {
-    return (*right <= *static_cast<const BinaryPropOp &>(other).right);
+  const BinaryPropOp &op = static_cast<const BinaryPropOp &>(other);
+  if (int result = left->compare(*op.left)) {
+    return result;
   }
+  return right->compare(*op.right);
 }
 
 ASTNode::Type And::get_type() const { return ASTNode::Type::And; }
@@ -309,9 +378,23 @@ bool And::evaluate_subt(const std::vector<std::string> &trace, size_t begin,
   return left->evaluate_subt(trace, begin, end) &&
          right->evaluate_subt(trace, begin, end);
 }
+bool And::evaluate_subt(const Trace &trace, size_t begin, size_t end) const {
+  return left->evaluate_subt(trace, begin, end) &&
+         right->evaluate_subt(trace, begin, end);
+}
+bool And::evaluate_subt(const MemoTrace &trace, size_t begin,
+                        size_t end) const {
+  return trace.memoize(*this, begin, end, [&] {
+    return left->evaluate_subt(trace, begin, end) &&
+           right->evaluate_subt(trace, begin, end);
+  });
+}
 std::shared_ptr<ASTNode> And::deep_copy() const {
   return std::make_shared<And>(left->deep_copy(), right->deep_copy());
 }
+std::shared_ptr<ASTNode> And::deep_copy(ASTArena &arena) const {
+  return arena.make<And>(left->deep_copy(arena), right->deep_copy(arena));
+}
 
 ASTNode::Type Xor::get_type() const { return ASTNode::Type::Xor; }
 std::string Xor::get_symbol() const { return "^"; }
@@ -320,9 +403,23 @@ bool Xor::evaluate_subt(const std::vector<std::string> &trace, size_t begin,
   return left->evaluate_subt(trace, begin, end) !=
          right->evaluate_subt(trace, begin, end);
 }
+bool Xor::evaluate_subt(const Trace &trace, size_t begin, size_t end) const {
+  return left->evaluate_subt(trace, begin, end) !=
+         right->evaluate_subt(trace, begin, end);
+}
+bool Xor::evaluate_subt(const MemoTrace &trace, size_t begin,
+                        size_t end) const {
+  return trace.memoize(*this, begin, end, [&] {
+    return left->evaluate_subt(trace, begin, end) !=
+           right->evaluate_subt(trace, begin, end);
+  });
+}
 std::shared_ptr<ASTNode> Xor::deep_copy() const {
   return std::make_shared<Xor>(left->deep_copy(), right->deep_copy());
 }
+std::shared_ptr<ASTNode> Xor::deep_copy(ASTArena &arena) const {
+  return arena.make<Xor>(left->deep_copy(arena), right->deep_copy(arena));
+}
 
 ASTNode::Type Or::get_type() const { return ASTNode::Type::Or; }
 std::string Or::get_symbol() const { return "|"; }
@@ -331,9 +428,22 @@ bool Or::evaluate_subt(const std::vector<std::string> &trace, size_t begin,
   return left->evaluate_subt(trace, begin, end) ||
          right->evaluate_subt(trace, begin, end);
 }
+bool Or::evaluate_subt(const Trace &trace, size_t begin, size_t end) const {
+  return left->evaluate_subt(trace, begin, end) ||
+         right->evaluate_subt(trace, begin, end);
+}
+bool Or::evaluate_subt(const MemoTrace &trace, size_t begin, size_t end) const {
+  return trace.memoize(*this, begin, end, [&] {
+    return left->evaluate_subt(trace, begin, end) ||
+           right->evaluate_subt(trace, begin, end);
+  });
+}
 std::shared_ptr<ASTNode> Or::deep_copy() const {
   return std::make_shared<Or>(left->deep_copy(), right->deep_copy());
 }
+std::shared_ptr<ASTNode> Or::deep_copy(ASTArena &arena) const {
+  return arena.make<Or>(left->deep_copy(arena), right->deep_copy(arena));
+}
 
 ASTNode::Type Implies::get_type() const { return ASTNode::Type::Implies; }
 std::string Implies::get_symbol() const { return "->"; }
@@ -342,9 +452,24 @@ bool Implies::evaluate_subt(const std::vector<std::string> &trace, size_t begin,
   return !left->evaluate_subt(trace, begin, end) ||
          right->evaluate_subt(trace, begin, end);
 }
+bool Implies::evaluate_subt(const Trace &trace, size_t begin,
+                            size_t end) const {
+  return !left->evaluate_subt(trace, begin, end) ||
+         right->evaluate_subt(trace, begin, end);
+}
+bool Implies::evaluate_subt(const MemoTrace &trace, size_t begin,
+                            size_t end) const {
+  return trace.memoize(*this, begin, end, [&] {
+    return !left->evaluate_subt(trace, begin, end) ||
+           right->evaluate_subt(trace, begin, end);
+  });
+}
 std::shared_ptr<ASTNode> Implies::deep_copy() const {
   return std::make_shared<Implies>(left->deep_copy(), right->deep_copy());
 }
+std::shared_ptr<ASTNode> Implies::deep_copy(ASTArena &arena) const {
+  return arena.make<Implies>(left->deep_copy(arena), right->deep_copy(arena));
+}
 
 ASTNode::Type Equiv::get_type() const { return ASTNode::Type::Equiv; }
 std::string Equiv::get_symbol() const { return "<->"; }
@@ -353,14 +478,35 @@ bool Equiv::evaluate_subt(const std::vector<std::string> &trace, size_t begin,
   return left->evaluate_subt(trace, begin, end) ==
          right->evaluate_subt(trace, begin, end);
 }
+bool Equiv::evaluate_subt(const Trace &trace, size_t begin, size_t end) const {
+  return left->evaluate_subt(trace, begin, end) ==
+         right->evaluate_subt(trace, begin, end);
+}
+bool Equiv::evaluate_subt(const MemoTrace &trace, size_t begin,
+                          size_t end) const {
+  return trace.memoize(*this, begin, end, [&] {
+    return left->evaluate_subt(trace, begin, end) ==
+           right->evaluate_subt(trace, begin, end);
+  });
+}
 std::shared_ptr<ASTNode> Equiv::deep_copy() const {
   return std::make_shared<Equiv>(left->deep_copy(), right->deep_copy());
 }
+std::shared_ptr<ASTNode> Equiv::deep_copy(ASTArena &arena) const {
+  return arena.make<Equiv>(left->deep_copy(arena), right->deep_copy(arena));
+}
 
 BinaryTempOp::BinaryTempOp() : BinaryOp(), lb(0), ub(0) {}
 BinaryTempOp::BinaryTempOp(std::shared_ptr<ASTNode> left,
                            std::shared_ptr<ASTNode> right, size_t lb, size_t ub)
-    : BinaryOp(std::move(left), std::move(right)), lb(lb), ub(ub) {}
+    : BinaryOp(std::move(left), std::move(right)), lb(lb), ub(ub) {
+  update_hash();
+}
+
+void BinaryTempOp::update_hash() {
+  BinaryOp::update_hash();
+  hash_value = hash_combine(hash_combine(hash_value, lb), ub);
+}
 
 bool BinaryTempOp::is_propositional_op() const { return false; }
 bool BinaryTempOp::is_temporal_op() const { return true; }
@@ -394,44 +540,27 @@ size_t BinaryTempOp::future_reach() const {
   }
   return ub + rfr;
 }
-bool BinaryTempOp::operator==(const ASTNode &other) const {
-  return ((get_type() == other.get_type()) &&
-          (*left == *static_cast<const BinaryTempOp &>(other).left) &&
-          (*right == *static_cast<const BinaryTempOp &>(other).right) &&
-          (lb == static_cast<const BinaryTempOp &>(other).lb) &&
-          (ub == static_cast<const BinaryTempOp &>(other).ub));
-}
-bool BinaryTempOp::operator<(const ASTNode &other) const {
-  if (get_type() != other.get_type()) {
-    return (get_type() < other.get_type());
-  } else if (*left != *static_cast<const BinaryTempOp &>(other).left) {
-    return (*left < *static_cast<const BinaryTempOp &>(other).left);
-  } else if (*right != *static_cast<const BinaryTempOp &>(other).right) {
-    return (*right < *static_cast<const BinaryTempOp &>(other).right);
-  } else if (lb != static_cast<const BinaryTempOp &>(other).lb) {
-    return (lb < static_cast<const BinaryTempOp &>(other).lb);
-  } else {
-    return (ub < static_cast<const BinaryTempOp &>(other).ub);
+int BinaryTempOp::compare(const ASTNode &other) const {
+  if (this == &other) {
+    return 0;
+  } else if (get_type() != other.get_type()) {
+    return compare_values(get_type(), other.get_type());
   }
-}
-bool BinaryTempOp::operator<=(const ASTNode &other) const {
-  if (get_type() != other.get_type()) {
-    return (get_type() <= other.get_type());
-  } else if (*left != *static_cast<const BinaryTempOp &>(other).left) {
-    return (*left <= *static_cast<const BinaryTempOp &>(other).left);
-  } else if (*right != *static_cast<const BinaryTempOp &>(other).right) {
-    return (*right <= *static_cast<const BinaryTempOp &>(other).right);
-  } else if (lb != static_cast<const BinaryTempOp &>(other).lb) {
-    return (lb <= static_cast<const BinaryTempOp &>(other).lb);
-  } else {
-    return (ub <= static_cast<const BinaryTempOp &>(other).ub);
+  const BinaryTempOp &op = static_cast<const BinaryTempOp &>(other);
+  if (int result = left->compare(*op.left)) {
+    return result;
   }
+  if (int result = right->compare(*op.right)) {
+    return result;
+  } else if (lb != op.lb) {
+    return compare_values(lb, op.lb);
+  }
+  return compare_values(ub, op.ub);
 }
 
-ASTNode::Type Until::get_type() const { return ASTNode::Type::Until; }
-std::string Until::get_symbol() const { return "U"; }
-bool Until::evaluate_subt(const vector<string> &trace, size_t begin,
-                          size_t end) const {
+template <typename T>
+bool until_subt(const ASTNode &left, const ASTNode &right, size_t lb,
+                size_t ub, const T &trace, size_t begin, size_t end) {
   size_t subt_len = end - begin;
   if (subt_len <= lb) {
     return false;
@@ -441,7 +570,7 @@ bool Until::evaluate_subt(const vector<string> &trace, size_t begin,
   size_t idx_end = min(idx_ub + 1, end);
   size_t i = -1;
   for (size_t k = idx_lb; k < idx_end; ++k) {
-    if (right->evaluate_subt(trace, k, end)) {
+    if (right.evaluate_subt(trace, k, end)) {
       i = k;
       break;
     }
@@ -450,20 +579,39 @@ bool Until::evaluate_subt(const vector<string> &trace, size_t begin,
     return false;
   }
   for (size_t j = idx_lb; j < i; ++j) {
-    if (!left->evaluate_subt(trace, j, end)) {
+    if (!left.evaluate_subt(trace, j, end)) {
       return false;
     }
   }
   return true;
 }
+
+ASTNode::Type Until::get_type() const { return ASTNode::Type::Until; }
+std::string Until::get_symbol() const { return "U"; }
+bool Until::evaluate_subt(const vector<string> &trace, size_t begin,
+                          size_t end) const {
+  return until_subt(*left, *right, lb, ub, trace, begin, end);
+}
+bool Until::evaluate_subt(const Trace &trace, size_t begin, size_t end) const {
+  return until_subt(*left, *right, lb, ub, trace, begin, end);
+}
+bool Until::evaluate_subt(const MemoTrace &trace, size_t begin,
+                          size_t end) const {
+  return trace.memoize(*this, begin, end, [&] {
+    return until_subt(*left, *right, lb, ub, trace, begin, end);
+  });
+}
 std::shared_ptr<ASTNode> Until::deep_copy() const {
   return std::make_shared<Until>(left->deep_copy(), right->deep_copy(), lb, ub);
 }
+std::shared_ptr<ASTNode> Until::deep_copy(ASTArena &arena) const {
+  return arena.make<Until>(left->deep_copy(arena), right->deep_copy(arena),
+                           lb, ub);
+}
 
-ASTNode::Type Release::get_type() const { return ASTNode::Type::Release; }
-std::string Release::get_symbol() const { return "R"; }
-bool Release::evaluate_subt(const vector<string> &trace, size_t begin,
-                            size_t end) const {
+template <typename T>
+bool release_subt(const ASTNode &left, const ASTNode &right, size_t lb,
+                  size_t ub, const T &trace, size_t begin, size_t end) {
   size_t subt_len = end - begin;
   if (subt_len <= lb) {
     return true;
@@ -473,7 +621,7 @@ bool Release::evaluate_subt(const vector<string> &trace, size_t begin,
   size_t idx_end = min(idx_ub + 1, end);
   size_t i;
   for (i = idx_lb; i < idx_end; ++i) {
-    if (!right->evaluate_subt(trace, i, end)) {
+    if (!right.evaluate_subt(trace, i, end)) {
       break;
     }
   }
@@ -483,7 +631,7 @@ bool Release::evaluate_subt(const vector<string> &trace, size_t begin,
   size_t j = -1;
   size_t k;
   for (k = idx_lb; k < idx_end; ++k) {
-    if (left->evaluate_subt(trace, k, end)) {
+    if (left.evaluate_subt(trace, k, end)) {
       j = k + 1;
       break;
     }
@@ -495,15 +643,36 @@ bool Release::evaluate_subt(const vector<string> &trace, size_t begin,
   }
   idx_end = min(j, end);
   for (k = idx_lb; k < idx_end; ++k) {
-    if (!right->evaluate_subt(trace, k, end)) {
+    if (!right.evaluate_subt(trace, k, end)) {
       return false;
     }
   }
   return true;
 }
+
+ASTNode::Type Release::get_type() const { return ASTNode::Type::Release; }
+std::string Release::get_symbol() const { return "R"; }
+bool Release::evaluate_subt(const vector<string> &trace, size_t begin,
+                            size_t end) const {
+  return release_subt(*left, *right, lb, ub, trace, begin, end);
+}
+bool Release::evaluate_subt(const Trace &trace, size_t begin,
+                            size_t end) const {
+  return release_subt(*left, *right, lb, ub, trace, begin, end);
+}
+bool Release::evaluate_subt(const MemoTrace &trace, size_t begin,
+                            size_t end) const {
+  return trace.memoize(*this, begin, end, [&] {
+    return release_subt(*left, *right, lb, ub, trace, begin, end);
+  });
+}
 std::shared_ptr<ASTNode> Release::deep_copy() const {
   return std::make_shared<Release>(left->deep_copy(), right->deep_copy(), lb,
                                    ub);
 }
+std::shared_ptr<ASTNode> Release::deep_copy(ASTArena &arena) const {
+  return arena.make<Release>(left->deep_copy(arena),
+                             right->deep_copy(arena), lb, ub);
+}
 
 } // namespace libmltl
@@ -0,0 +1,332 @@
+#include "batch.hh"
+#include "kernels.hh"
+#include "satisfaction.hh"
+
+#include <algorithm>
+#include <stdexcept>
+
+using namespace std;
+namespace libmltl {
+
+TraceBatch::TraceBatch() : len(0), vars(0), count(0), lanes(0) {}
+
+void TraceBatch::init(size_t num_traces, size_t length, size_t num_vars) {
+  len = length;
+  vars = num_vars;
+  count = num_traces;
+  lanes = (num_traces + 63) / 64;
+  bits.assign(vars * len * lanes, 0);
+}
+
+TraceBatch::TraceBatch(const vector<Trace> &traces)
+    : TraceBatch(traces, 0, traces.size()) {}
+TraceBatch::TraceBatch(const vector<Trace> &traces, size_t begin, size_t end)
+    : TraceBatch() {
+  size_t length = (begin < end) ? traces[begin].size() : 0;
+  size_t num_vars = 0;
+  for (size_t k = begin; k < end; ++k) {
+    if (traces[k].size() != length) {
+      throw invalid_argument("traces in a batch must have the same length");
+    }
+    num_vars = max(num_vars, traces[k].num_vars());
+  }
+  init(end - begin, length, num_vars);
+  for (size_t k = begin; k < end; ++k) {
+    size_t lane = (k - begin) >> 6;
+    uint64_t mask = (uint64_t)1 << ((k - begin) & 63);
+    for (unsigned int id = 0; id < traces[k].num_vars(); ++id) {
+      const BitVector &column = traces[k].get_variable(id);
+      for (size_t t = column.find_next(0); t < len;
+           t = column.find_next(t + 1)) {
+        bits[(id * len + t) * lanes + lane] |= mask;
+      }
+    }
+  }
+}
+
+TraceBatch::TraceBatch(const vector<vector<string>> &traces)
+    : TraceBatch(traces, 0, traces.size()) {}
+TraceBatch::TraceBatch(const vector<vector<string>> &traces, size_t begin,
+                       size_t end)
+    : TraceBatch() {
+  size_t length = (begin < end) ? traces[begin].size() : 0;
+  size_t num_vars = 0;
+  for (size_t k = begin; k < end; ++k) {
+    if (traces[k].size() != length) {
+      throw invalid_argument("traces in a batch must have the same length");
+    }
+    if (length > 0) {
+      num_vars = max(num_vars, traces[k][0].length());
+    }
+  }
+  init(end - begin, length, num_vars);
+  for (size_t k = begin; k < end; ++k) {
+    size_t lane = (k - begin) >> 6;
+    uint64_t mask = (uint64_t)1 << ((k - begin) & 63);
+    for (size_t t = 0; t < len; ++t) {
+      // like ASTNode::evaluate, the first state determines the variables
+      const string &state = traces[k][t];
+      size_t width = min(state.length(), traces[k][0].length());
+      for (size_t id = 0; id < width; ++id) {
+        if (state[id] == '1') {
+          bits[(id * len + t) * lanes + lane] |= mask;
+        }
+      }
+    }
+  }
+}
+
+/* Bit-sliced satisfaction values of one subformula: word t * lanes + w holds
+ * the values at time step t for traces 64 * w to 64 * w + 63.
+ */
+typedef vector<uint64_t> Sliced;
+
+/* Bit-sliced (left U[lb,ub] right) over time steps [0, len), with the
+ * truncated trace semantics of Until::evaluate_subt.
+ *
+ * A segment of the trace is summarised by the pair (all, any): whether left
+ * holds everywhere in it, and whether right holds somewhere in it with left
+ * holding everywhere before. Concatenating segments is associative,
+ *   (all1, any1) . (all2, any2) = (all1 & all2, any1 | (all1 & any2)),
+ * so every window is combined from one suffix and one prefix aggregate of
+ * blocks as wide as the window (van Herk/Gil-Werman), in O(len) words for any
+ * window width. F is the special case where left is true everywhere.
+ */
+Sliced until_window(const Sliced &left, const Sliced &right, size_t len,
+                    size_t lanes, size_t lb, size_t ub) {
+  Sliced result(len * lanes, 0);
+  if (ub < lb || lb >= len) {
+    return result;
+  }
+  size_t width = min(ub - lb + 1, len);
+  Sliced pre_any(len * lanes), suf_all(len * lanes), suf_any(len * lanes);
+  vector<uint64_t> pre_all(lanes);
+  for (size_t j = 0; j < len; ++j) {
+    const uint64_t *l = &left[j * lanes];
+    const uint64_t *r = &right[j * lanes];
+    uint64_t *pe = &pre_any[j * lanes];
+    for (size_t w = 0; w < lanes; ++w) {
+      if (j % width == 0) {
+        pe[w] = r[w];
+        pre_all[w] = l[w];
+      } else {
+        pe[w] = pe[w - lanes] | (pre_all[w] & r[w]);
+        pre_all[w] &= l[w];
+      }
+    }
+  }
+  for (size_t j = len; j-- > 0;) {
+    const uint64_t *l = &left[j * lanes];
+    const uint64_t *r = &right[j * lanes];
+    uint64_t *sa = &suf_all[j * lanes];
+    uint64_t *se = &suf_any[j * lanes];
+    bool block_end = (j % width == width - 1) || (j == len - 1);
+    for (size_t w = 0; w < lanes; ++w) {
+      if (block_end) {
+        sa[w] = l[w];
+        se[w] = r[w];
+      } else {
+        sa[w] = l[w] & sa[w + lanes];
+        se[w] = r[w] | (l[w] & se[w + lanes]);
+      }
+    }
+  }
+  for (size_t i = 0; i + lb < len; ++i) {
+    size_t a = i + lb;
+    size_t e = min(i + ub, len - 1);
+    uint64_t *out = &result[i * lanes];
+    if (a / width == e / width) {
+      // the suffix of the block starting at a ends exactly at e
+      copy_n(&suf_any[a * lanes], lanes, out);
+    } else {
+      for (size_t w = 0; w < lanes; ++w) {
+        out[w] = suf_any[a * lanes + w] |
+                 (suf_all[a * lanes + w] & pre_any[e * lanes + w]);
+      }
+    }
+  }
+  return result;
+}
+
+Sliced sliced_not(Sliced operand) {
+  bitwise_not(operand.data(), operand.data(), operand.size());
+  return operand;
+}
+
+Sliced evaluate_sliced(const ASTNode &formula, const TraceBatch &batch,
+                       size_t len) {
+  size_t lanes = batch.num_lanes();
+  switch (formula.get_type()) {
+  case ASTNode::Type::Constant:
+    return Sliced(len * lanes,
+                  static_cast<const Constant &>(formula).get_value()
+                      ? ~(uint64_t)0
+                      : 0);
+  case ASTNode::Type::Variable: {
+    unsigned int id = static_cast<const Variable &>(formula).get_id();
+    if (id >= batch.num_vars()) {
+      return Sliced(len * lanes, 0);
+    }
+    const uint64_t *rows = batch.get_variable(id, 0);
+    return Sliced(rows, rows + len * lanes);
+  }
+  case ASTNode::Type::Negation:
+    return sliced_not(evaluate_sliced(
+        static_cast<const UnaryOp &>(formula).get_operand(), batch, len));
+  case ASTNode::Type::Finally:
+  case ASTNode::Type::Globally: {
+    const UnaryTempOp &op = static_cast<const UnaryTempOp &>(formula);
+    Sliced operand = evaluate_sliced(op.get_operand(), batch, len);
+    Sliced always(len * lanes, ~(uint64_t)0);
+    if (formula.get_type() == ASTNode::Type::Finally) {
+      return until_window(always, operand, len, lanes, op.get_lower_bound(),
+                          op.get_upper_bound());
+    }
+    // G[lb,ub] p == ~F[lb,ub] ~p
+    return sliced_not(until_window(always, sliced_not(std::move(operand)), len,
+                                   lanes, op.get_lower_bound(),
+                                   op.get_upper_bound()));
+  }
+  default:
+    break;
+  }
+
+  const BinaryOp &op = static_cast<const BinaryOp &>(formula);
+  Sliced left = evaluate_sliced(op.get_left(), batch, len);
+  Sliced right = evaluate_sliced(op.get_right(), batch, len);
+  switch (formula.get_type()) {
+  case ASTNode::Type::And:
+    bitwise_and(left.data(), left.data(), right.data(), left.size());
+    return left;
+  case ASTNode::Type::Xor:
+    bitwise_xor(left.data(), left.data(), right.data(), left.size());
+    return left;
+  case ASTNode::Type::Or:
+    bitwise_or(left.data(), left.data(), right.data(), left.size());
+    return left;
+  case ASTNode::Type::Implies:
+    bitwise_implies(left.data(), left.data(), right.data(), left.size());
+    return left;
+  case ASTNode::Type::Equiv:
+    bitwise_equiv(left.data(), left.data(), right.data(), left.size());
+    return left;
+  case ASTNode::Type::Until: {
+    const BinaryTempOp &temp_op = static_cast<const BinaryTempOp &>(formula);
+    return until_window(left, right, len, lanes, temp_op.get_lower_bound(),
+                        temp_op.get_upper_bound());
+  }
+  default: { // ASTNode::Type::Release
+    const BinaryTempOp &temp_op = static_cast<const BinaryTempOp &>(formula);
+    size_t lb = temp_op.get_lower_bound();
+    size_t ub = temp_op.get_upper_bound();
+    if (ub < lb) {
+      // see window_release in kernels.cc
+      Sliced result(len * lanes, ~(uint64_t)0);
+      if (ub + 1 != lb) {
+        fill_n(result.begin(), (len - min(lb, len)) * lanes, 0);
+      }
+      return result;
+    }
+    // l R[lb,ub] r == ~(~l U[lb,ub] ~r)
+    return sliced_not(until_window(sliced_not(std::move(left)),
+                                   sliced_not(std::move(right)), len, lanes,
+                                   lb, ub));
+  }
+  }
+}
+
+BitVector evaluate_batch(const ASTNode &formula, const TraceBatch &batch) {
+  BitVector result(batch.num_traces());
+  if (batch.size() == 0) {
+    return BitVector(batch.num_traces(),
+                     formula.evaluate(vector<string>()));
+  }
+  // only the verdict at time step 0 is needed, and states past the
+  // evaluation reach cannot change it
+  size_t len = min(batch.size(), max((size_t)1, evaluation_reach(formula)));
+  Sliced verdicts = evaluate_sliced(formula, batch, len);
+  copy_n(verdicts.begin(), result.num_words(), result.data());
+  result.clear_padding();
+  return result;
+}
+
+/* Traces per block of the formula x trace matrix: the TraceBatch of a block
+ * should take up at most block_bytes, so it stays in L2 together with the
+ * intermediate results of a formula, and the block has at most
+ * max_block_lanes lanes, one AVX2 register per time step.
+ */
+constexpr size_t block_bytes = 256 * 1024;
+constexpr size_t max_block_lanes = 4;
+
+vector<BitVector> evaluate_batch(const vector<shared_ptr<ASTNode>> &formulas,
+                                 const vector<Trace> &traces,
+                                 ThreadPool &pool) {
+  vector<BitVector> result(formulas.size(), BitVector(traces.size()));
+  if (formulas.empty() || traces.empty()) {
+    return result;
+  }
+  // blocks start at multiples of 64, so tiles write disjoint result words
+  vector<size_t> block_begin = {0};
+  while (block_begin.back() < traces.size()) {
+    const Trace &first = traces[block_begin.back()];
+    size_t lane_bytes = max((size_t)1, first.num_vars() * first.size()) * 8;
+    size_t lanes = clamp(block_bytes / lane_bytes, (size_t)1, max_block_lanes);
+    block_begin.push_back(min(block_begin.back() + 64 * lanes, traces.size()));
+  }
+  size_t num_blocks = block_begin.size() - 1;
+
+  // empty if the traces of the block differ in length
+  vector<TraceBatch> batches(num_blocks);
+  pool.run(num_blocks, [&](size_t b) {
+    size_t begin = block_begin[b], end = block_begin[b + 1];
+    for (size_t k = begin; k < end; ++k) {
+      if (traces[k].size() != traces[begin].size()) {
+        return;
+      }
+    }
+    batches[b] = TraceBatch(traces, begin, end);
+  });
+
+  // a few tiles per thread, so stealing can even out the load
+  size_t tiles_per_block = (4 * pool.size() + num_blocks - 1) / num_blocks;
+  tiles_per_block = min(tiles_per_block, formulas.size());
+  size_t formulas_per_tile =
+      (formulas.size() + tiles_per_block - 1) / tiles_per_block;
+  size_t num_formula_blocks =
+      (formulas.size() + formulas_per_tile - 1) / formulas_per_tile;
+  pool.run(num_blocks * num_formula_blocks, [&](size_t tile) {
+    size_t b = tile / num_formula_blocks;
+    size_t begin = block_begin[b], end = block_begin[b + 1];
+    size_t first = (tile % num_formula_blocks) * formulas_per_tile;
+    size_t last = min(first + formulas_per_tile, formulas.size());
+    for (size_t i = first; i < last; ++i) {
+      if (batches[b].num_traces() > 0) {
+        BitVector verdicts = evaluate_batch(*formulas[i], batches[b]);
+        copy_n(verdicts.data(), verdicts.num_words(),
+               result[i].data() + begin / 64);
+      } else {
+        for (size_t k = begin; k < end; ++k) {
+          result[i].set(k, formulas[i]->evaluate(traces[k]));
+        }
+      }
+    }
+  });
+  return result;
+}
+
+vector<BitVector> evaluate_batch(const vector<shared_ptr<ASTNode>> &formulas,
+                                 const vector<Trace> &traces,
+                                 unsigned int num_threads) {
+  ThreadPool pool(num_threads);
+  return evaluate_batch(formulas, traces, pool);
+}
+vector<BitVector> evaluate_batch(const vector<shared_ptr<ASTNode>> &formulas,
+                                 const vector<vector<string>> &traces,
+                                 unsigned int num_threads) {
+  ThreadPool pool(num_threads);
+  vector<Trace> packed(traces.size());
+  pool.run(traces.size(), [&](size_t k) { packed[k] = Trace(traces[k]); });
+  return evaluate_batch(formulas, packed, pool);
+}
+
+} // namespace libmltl
@@ -0,0 +1,181 @@
+#include "compiled.hh"
+#include "kernels.hh"
+#include "satisfaction.hh"
+
+#include <algorithm>
+
+using namespace std;
+namespace libmltl {
+
+CompiledFormula::CompiledFormula() : reach(0) {
+  program.push_back({Opcode::Constant, 0, 0, false, 0});
+}
+CompiledFormula::CompiledFormula(const ASTNode &formula)
+    : reach(libmltl::evaluation_reach(formula)) {
+  program.reserve(formula.size());
+  compile(formula);
+}
+
+uint32_t CompiledFormula::compile(const ASTNode &formula) {
+  Instruction ins = {Opcode::Constant, 0, 0, 0, 0};
+  switch (formula.get_type()) {
+  case ASTNode::Type::Constant:
+    ins.lb = static_cast<const Constant &>(formula).get_value();
+    break;
+  case ASTNode::Type::Variable:
+    ins.op = Opcode::Variable;
+    ins.lb = static_cast<const Variable &>(formula).get_id();
+    break;
+  case ASTNode::Type::Negation:
+    ins.op = Opcode::Negation;
+    break;
+  case ASTNode::Type::And:
+    ins.op = Opcode::And;
+    break;
+  case ASTNode::Type::Xor:
+    ins.op = Opcode::Xor;
+    break;
+  case ASTNode::Type::Or:
+    ins.op = Opcode::Or;
+    break;
+  case ASTNode::Type::Implies:
+    ins.op = Opcode::Implies;
+    break;
+  case ASTNode::Type::Equiv:
+    ins.op = Opcode::Equiv;
+    break;
+  case ASTNode::Type::Finally:
+  case ASTNode::Type::Globally: {
+    const UnaryTempOp &op = static_cast<const UnaryTempOp &>(formula);
+    ins.op = (formula.get_type() == ASTNode::Type::Finally) ? Opcode::Finally
+                                                            : Opcode::Globally;
+    ins.lb = op.get_lower_bound();
+    ins.ub = op.get_upper_bound();
+    break;
+  }
+  case ASTNode::Type::Until:
+  case ASTNode::Type::Release: {
+    const BinaryTempOp &op = static_cast<const BinaryTempOp &>(formula);
+    ins.op = (formula.get_type() == ASTNode::Type::Until) ? Opcode::Until
+                                                          : Opcode::Release;
+    ins.lb = op.get_lower_bound();
+    ins.ub = op.get_upper_bound();
+    break;
+  }
+  }
+  if (formula.is_unary_op()) {
+    ins.left = compile(static_cast<const UnaryOp &>(formula).get_operand());
+  } else if (formula.is_binary_op()) {
+    const BinaryOp &op = static_cast<const BinaryOp &>(formula);
+    ins.left = compile(op.get_left());
+    ins.right = compile(op.get_right());
+  }
+  program.push_back(ins);
+  return program.size() - 1;
+}
+
+bool CompiledFormula::evaluate(const Trace &trace) const {
+  if (trace.size() == 0) {
+    // every subformula is decided by the truncated trace semantics alone
+    vector<bool> value(program.size());
+    for (size_t i = 0; i < program.size(); ++i) {
+      const Instruction &ins = program[i];
+      bool l = value[ins.left], r = value[ins.right];
+      switch (ins.op) {
+      case Opcode::Constant:
+        value[i] = ins.lb;
+        break;
+      case Opcode::Negation:
+        value[i] = !l;
+        break;
+      case Opcode::And:
+        value[i] = l && r;
+        break;
+      case Opcode::Xor:
+        value[i] = l != r;
+        break;
+      case Opcode::Or:
+        value[i] = l || r;
+        break;
+      case Opcode::Implies:
+        value[i] = !l || r;
+        break;
+      case Opcode::Equiv:
+        value[i] = l == r;
+        break;
+      case Opcode::Globally:
+      case Opcode::Release:
+        value[i] = true;
+        break;
+      default: // Variable, Finally, Until
+        value[i] = false;
+        break;
+      }
+    }
+    return value.back();
+  }
+
+  size_t n = min(trace.size(), max((size_t)1, reach));
+  size_t num_words = (n + 63) / 64;
+  uint64_t mask = (n & 63) ? ((uint64_t)1 << (n & 63)) - 1 : ~(uint64_t)0;
+  thread_local vector<uint64_t> registers;
+  registers.resize(program.size() * num_words);
+  uint64_t *base = registers.data();
+
+  for (size_t i = 0; i < program.size(); ++i) {
+    const Instruction &ins = program[i];
+    uint64_t *dst = base + i * num_words;
+    const uint64_t *l = base + ins.left * num_words;
+    const uint64_t *r = base + ins.right * num_words;
+    switch (ins.op) {
+    case Opcode::Constant:
+      fill_n(dst, num_words, ins.lb ? ~(uint64_t)0 : 0);
+      break;
+    case Opcode::Variable:
+      if (ins.lb < trace.num_vars()) {
+        copy_n(trace.get_variable(ins.lb).data(), num_words, dst);
+      } else {
+        fill_n(dst, num_words, 0);
+      }
+      break;
+    case Opcode::Negation:
+      bitwise_not(dst, l, num_words);
+      break;
+    case Opcode::And:
+      bitwise_and(dst, l, r, num_words);
+      break;
+    case Opcode::Xor:
+      bitwise_xor(dst, l, r, num_words);
+      break;
+    case Opcode::Or:
+      bitwise_or(dst, l, r, num_words);
+      break;
+    case Opcode::Implies:
+      bitwise_implies(dst, l, r, num_words);
+      break;
+    case Opcode::Equiv:
+      bitwise_equiv(dst, l, r, num_words);
+      break;
+    case Opcode::Finally:
+      window_any(dst, l, n, ins.lb, ins.ub);
+      break;
+    case Opcode::Globally:
+      window_all(dst, l, n, ins.lb, ins.ub);
+      break;
+    case Opcode::Until:
+      window_until(dst, l, r, n, ins.lb, ins.ub);
+      break;
+    case Opcode::Release:
+      window_release(dst, l, r, n, ins.lb, ins.ub);
+      break;
+    }
+    // the window kernels need zero padding past the prefix
+    dst[num_words - 1] &= mask;
+  }
+  return base[(program.size() - 1) * num_words] & 1;
+}
+bool CompiledFormula::evaluate(const vector<string> &trace) const {
+  return evaluate(Trace(trace));
+}
+
+} // namespace libmltl
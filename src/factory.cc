@@ -0,0 +1,114 @@
+#include "factory.hh"
+
+using namespace std;
+namespace libmltl {
+
+size_t FormulaFactory::KeyHash::operator()(const Key &key) const {
+  size_t result = hash_combine((size_t)key.type, key.lb);
+  result = hash_combine(result, key.ub);
+  result = hash_combine(result, key.left ? key.left->hash() : 0);
+  return hash_combine(result, key.right ? key.right->hash() : 0);
+}
+
+shared_ptr<ASTNode> FormulaFactory::get(ASTNode::Type type, size_t lb,
+                                        size_t ub,
+                                        const shared_ptr<ASTNode> &left,
+                                        const shared_ptr<ASTNode> &right) {
+  Key key = {type, lb, ub, left.get(), right.get()};
+  auto it = nodes.find(key);
+  if (it != nodes.end()) {
+    return it->second;
+  }
+  shared_ptr<ASTNode> node;
+  switch (type) {
+  case ASTNode::Type::Constant:
+    node = make_shared<Constant>(lb != 0);
+    break;
+  case ASTNode::Type::Variable:
+    node = make_shared<Variable>((unsigned int)lb);
+    break;
+  case ASTNode::Type::Negation:
+    node = make_shared<Negation>(left);
+    break;
+  case ASTNode::Type::And:
+    node = make_shared<And>(left, right);
+    break;
+  case ASTNode::Type::Xor:
+    node = make_shared<Xor>(left, right);
+    break;
+  case ASTNode::Type::Or:
+    node = make_shared<Or>(left, right);
+    break;
+  case ASTNode::Type::Implies:
+    node = make_shared<Implies>(left, right);
+    break;
+  case ASTNode::Type::Equiv:
+    node = make_shared<Equiv>(left, right);
+    break;
+  case ASTNode::Type::Finally:
+    node = make_shared<Finally>(left, lb, ub);
+    break;
+  case ASTNode::Type::Globally:
+    node = make_shared<Globally>(left, lb, ub);
+    break;
+  case ASTNode::Type::Until:
+    node = make_shared<Until>(left, right, lb, ub);
+    break;
+  case ASTNode::Type::Release:
+    node = make_shared<Release>(left, right, lb, ub);
+    break;
+  }
+  nodes.emplace(key, node);
+  return node;
+}
+
+shared_ptr<ASTNode> FormulaFactory::intern(const ASTNode &formula) {
+  Key key = {formula.get_type(), 0, 0, nullptr, nullptr};
+  switch (formula.get_type()) {
+  case ASTNode::Type::Constant:
+    key.lb = static_cast<const Constant &>(formula).get_value();
+    break;
+  case ASTNode::Type::Variable:
+    key.lb = static_cast<const Variable &>(formula).get_id();
+    break;
+  case ASTNode::Type::Finally:
+  case ASTNode::Type::Globally: {
+    const UnaryTempOp &op = static_cast<const UnaryTempOp &>(formula);
+    key.lb = op.get_lower_bound();
+    key.ub = op.get_upper_bound();
+    break;
+  }
+  case ASTNode::Type::Until:
+  case ASTNode::Type::Release: {
+    const BinaryTempOp &op = static_cast<const BinaryTempOp &>(formula);
+    key.lb = op.get_lower_bound();
+    key.ub = op.get_upper_bound();
+    break;
+  }
+  default:
+    break;
+  }
+  if (formula.is_unary_op()) {
+    key.left = &static_cast<const UnaryOp &>(formula).get_operand();
+  } else if (formula.is_binary_op()) {
+    const BinaryOp &op = static_cast<const BinaryOp &>(formula);
+    key.left = &op.get_left();
+    key.right = &op.get_right();
+  }
+
+  // found if the operands are interned already, in O(1)
+  auto it = nodes.find(key);
+  if (it != nodes.end()) {
+    return it->second;
+  }
+  shared_ptr<ASTNode> left, right;
+  if (key.left) {
+    left = intern(*key.left);
+  }
+  if (key.right) {
+    right = intern(*key.right);
+  }
+  return get(key.type, key.lb, key.ub, left, right);
+}
+
+} // namespace libmltl
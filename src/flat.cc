@@ -0,0 +1,158 @@
+#include "flat.hh"
+
+#include <algorithm>
+
+using namespace std;
+namespace libmltl {
+
+FlatFormula::FlatFormula()
+    : types{ASTNode::Type::Constant}, lbs{0}, ubs{0}, lefts{0}, rights{0},
+      values{false} {}
+FlatFormula::FlatFormula(const ASTNode &formula) {
+  size_t n = formula.size();
+  types.reserve(n);
+  lbs.reserve(n);
+  ubs.reserve(n);
+  lefts.reserve(n);
+  rights.reserve(n);
+  values.reserve(n);
+  flatten(formula);
+}
+
+uint32_t FlatFormula::flatten(const ASTNode &formula) {
+  uint32_t left = 0, right = 0;
+  size_t lb = 0, ub = 0;
+  unsigned int value = 0;
+  switch (formula.get_type()) {
+  case ASTNode::Type::Constant:
+    value = static_cast<const Constant &>(formula).get_value();
+    break;
+  case ASTNode::Type::Variable:
+    value = static_cast<const Variable &>(formula).get_id();
+    break;
+  case ASTNode::Type::Finally:
+  case ASTNode::Type::Globally: {
+    const UnaryTempOp &op = static_cast<const UnaryTempOp &>(formula);
+    lb = op.get_lower_bound();
+    ub = op.get_upper_bound();
+    break;
+  }
+  case ASTNode::Type::Until:
+  case ASTNode::Type::Release: {
+    const BinaryTempOp &op = static_cast<const BinaryTempOp &>(formula);
+    lb = op.get_lower_bound();
+    ub = op.get_upper_bound();
+    break;
+  }
+  default:
+    break;
+  }
+  if (formula.is_unary_op()) {
+    left = flatten(static_cast<const UnaryOp &>(formula).get_operand());
+  } else if (formula.is_binary_op()) {
+    const BinaryOp &op = static_cast<const BinaryOp &>(formula);
+    left = flatten(op.get_left());
+    right = flatten(op.get_right());
+  }
+  types.push_back(formula.get_type());
+  lbs.push_back(lb);
+  ubs.push_back(ub);
+  lefts.push_back(left);
+  rights.push_back(right);
+  values.push_back(value);
+  return types.size() - 1;
+}
+
+shared_ptr<ASTNode> FlatFormula::to_ast(ASTArena *arena) const {
+  vector<shared_ptr<ASTNode>> nodes(size());
+  for (size_t i = 0; i < size(); ++i) {
+    const shared_ptr<ASTNode> &left = nodes[lefts[i]];
+    const shared_ptr<ASTNode> &right = nodes[rights[i]];
+    switch (types[i]) {
+    case ASTNode::Type::Constant:
+      nodes[i] = make_node<Constant>(arena, values[i] != 0);
+      break;
+    case ASTNode::Type::Variable:
+      nodes[i] = make_node<Variable>(arena, values[i]);
+      break;
+    case ASTNode::Type::Negation:
+      nodes[i] = make_node<Negation>(arena, left);
+      break;
+    case ASTNode::Type::And:
+      nodes[i] = make_node<And>(arena, left, right);
+      break;
+    case ASTNode::Type::Xor:
+      nodes[i] = make_node<Xor>(arena, left, right);
+      break;
+    case ASTNode::Type::Or:
+      nodes[i] = make_node<Or>(arena, left, right);
+      break;
+    case ASTNode::Type::Implies:
+      nodes[i] = make_node<Implies>(arena, left, right);
+      break;
+    case ASTNode::Type::Equiv:
+      nodes[i] = make_node<Equiv>(arena, left, right);
+      break;
+    case ASTNode::Type::Finally:
+      nodes[i] = make_node<Finally>(arena, left, lbs[i], ubs[i]);
+      break;
+    case ASTNode::Type::Globally:
+      nodes[i] = make_node<Globally>(arena, left, lbs[i], ubs[i]);
+      break;
+    case ASTNode::Type::Until:
+      nodes[i] = make_node<Until>(arena, left, right, lbs[i], ubs[i]);
+      break;
+    case ASTNode::Type::Release:
+      nodes[i] = make_node<Release>(arena, left, right, lbs[i], ubs[i]);
+      break;
+    }
+  }
+  return nodes.back();
+}
+shared_ptr<ASTNode> FlatFormula::to_ast() const { return to_ast(nullptr); }
+shared_ptr<ASTNode> FlatFormula::to_ast(ASTArena &arena) const {
+  return to_ast(&arena);
+}
+
+/* Number of operands of a node of every type, in the order of ASTNode::Type.
+ */
+constexpr uint8_t arities[] = {0, 0, 1, 2, 2, 2, 2, 2, 1, 1, 2, 2};
+
+size_t FlatFormula::future_reach() const {
+  vector<size_t> reach(size());
+  for (size_t i = 0; i < size(); ++i) {
+    // leaves point at node 0, so the operands that do not exist are masked
+    unsigned int arity = arities[(int)types[i]];
+    size_t l = (arity > 0) ? reach[lefts[i]] : 0;
+    size_t r = (arity > 1) ? reach[rights[i]] : 0;
+    // like BinaryTempOp::future_reach, (l > r) ? ub + l - 1 : ub + r
+    size_t temporal = types[i] == ASTNode::Type::Until ||
+                      types[i] == ASTNode::Type::Release;
+    reach[i] = ubs[i] + max(l, r + temporal) - temporal +
+               (types[i] == ASTNode::Type::Variable);
+  }
+  return reach.back();
+}
+
+size_t FlatFormula::depth() const {
+  vector<uint32_t> depths(size());
+  for (size_t i = 0; i < size(); ++i) {
+    // leaves point at node 0, which is a leaf of depth 0 itself
+    depths[i] = (arities[(int)types[i]] > 0) +
+                max(depths[lefts[i]], depths[rights[i]]);
+  }
+  return depths.back();
+}
+
+size_t FlatFormula::count(ASTNode::Type target_type) const {
+  return std::count(types.begin(), types.end(), target_type);
+}
+
+bool FlatFormula::operator==(const FlatFormula &other) const {
+  // the postfix order of a tree is unique, so equal trees have equal arrays
+  return types == other.types && values == other.values &&
+         lefts == other.lefts && rights == other.rights && lbs == other.lbs &&
+         ubs == other.ubs;
+}
+
+} // namespace libmltl
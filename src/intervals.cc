@@ -0,0 +1,266 @@
+#include "intervals.hh"
+
+#include <algorithm>
+
+using namespace std;
+namespace libmltl {
+
+IntervalSet::IntervalSet() {}
+
+IntervalSet::IntervalSet(const BitVector &bits) {
+  for (size_t t = bits.find_next(0); t < bits.size();
+       t = bits.find_next(t)) {
+    size_t end = bits.find_next_unset(t);
+    bounds.push_back(t);
+    bounds.push_back(end);
+    t = end;
+  }
+}
+
+void IntervalSet::push_back(size_t begin, size_t end) {
+  if (begin >= end) {
+    return;
+  }
+  if (!bounds.empty() && begin <= bounds.back()) {
+    bounds.back() = max(bounds.back(), end);
+    return;
+  }
+  bounds.push_back(begin);
+  bounds.push_back(end);
+}
+
+bool IntervalSet::contains(size_t t) const {
+  // t is inside iff an odd number of bounds is <= t
+  return (upper_bound(bounds.begin(), bounds.end(), t) - bounds.begin()) & 1;
+}
+
+size_t IntervalSet::count() const {
+  size_t result = 0;
+  for (size_t k = 0; k < num_intervals(); ++k) {
+    result += end(k) - begin(k);
+  }
+  return result;
+}
+
+BitVector IntervalSet::to_bitvector(size_t len) const {
+  BitVector result(len);
+  uint64_t *words = result.data();
+  for (size_t k = 0; k < num_intervals(); ++k) {
+    size_t t = begin(k), e = end(k);
+    // partial first word, whole words, partial last word
+    while (t < e && (t & 63)) {
+      words[t >> 6] |= (uint64_t)1 << (t & 63);
+      ++t;
+    }
+    for (; t + 64 <= e; t += 64) {
+      words[t >> 6] = ~(uint64_t)0;
+    }
+    for (; t < e; ++t) {
+      words[t >> 6] |= (uint64_t)1 << (t & 63);
+    }
+  }
+  return result;
+}
+
+IntervalTrace::IntervalTrace() : len(0) {}
+IntervalTrace::IntervalTrace(size_t length, const vector<IntervalSet> &columns)
+    : len(length), columns(columns) {}
+IntervalTrace::IntervalTrace(const Trace &trace) : len(trace.size()) {
+  for (unsigned int id = 0; id < trace.num_vars(); ++id) {
+    columns.emplace_back(trace.get_variable(id));
+  }
+}
+IntervalTrace::IntervalTrace(const vector<string> &trace)
+    : IntervalTrace(Trace(trace)) {}
+
+void IntervalTrace::push_back(const string &state) {
+  if (len == 0 && columns.empty()) {
+    columns.resize(state.length());
+  }
+  size_t width = min(state.length(), columns.size());
+  for (size_t id = 0; id < width; ++id) {
+    if (state[id] == '1') {
+      columns[id].push_back(len, len + 1);
+    }
+  }
+  ++len;
+}
+
+Trace IntervalTrace::to_trace() const {
+  Trace result(columns.size(), len);
+  for (unsigned int id = 0; id < columns.size(); ++id) {
+    result.get_variable(id) = columns[id].to_bitvector(len);
+  }
+  return result;
+}
+
+/* Combines two sets time step by time step with op, by walking the bounds of
+ * both in order. Time steps in neither set map to op(false, false), which
+ * must be false.
+ */
+template <typename Op>
+IntervalSet merge(const IntervalSet &a, const IntervalSet &b, Op op) {
+  IntervalSet result;
+  size_t ka = 0, kb = 0;
+  // the bounds are 2 * k (+ 1 for the end) in either set
+  size_t na = 2 * a.num_intervals(), nb = 2 * b.num_intervals();
+  auto bound = [](const IntervalSet &s, size_t k) {
+    return (k & 1) ? s.end(k / 2) : s.begin(k / 2);
+  };
+  bool inside = false;
+  size_t begin = 0;
+  while (ka < na || kb < nb) {
+    size_t t = min(ka < na ? bound(a, ka) : (size_t)-1,
+                   kb < nb ? bound(b, kb) : (size_t)-1);
+    while (ka < na && bound(a, ka) == t) {
+      ++ka;
+    }
+    while (kb < nb && bound(b, kb) == t) {
+      ++kb;
+    }
+    // an odd number of bounds passed means inside an interval
+    bool now = op((ka & 1) != 0, (kb & 1) != 0);
+    if (now && !inside) {
+      begin = t;
+    } else if (!now && inside) {
+      result.push_back(begin, t);
+    }
+    inside = now;
+  }
+  return result;
+}
+
+/* The time steps of [0, len) not in set.
+ */
+IntervalSet complement(const IntervalSet &set, size_t len) {
+  IntervalSet all;
+  all.push_back(0, len);
+  return merge(all, set, [](bool a, bool b) { return a && !b; });
+}
+
+/* {i : i + a <= k <= i + b for some k in set}, the time steps that see set in
+ * the window [a, b].
+ */
+IntervalSet shift_window(const IntervalSet &set, size_t a, size_t b) {
+  IntervalSet result;
+  if (b < a) {
+    return result;
+  }
+  for (size_t k = 0; k < set.num_intervals(); ++k) {
+    size_t s = set.begin(k), e = set.end(k);
+    if (e > a) {
+      result.push_back(s > b ? s - b : 0, e - a);
+    }
+  }
+  return result;
+}
+
+/* left U[a,b] right. j = i + a satisfies it iff the first time step k >= j
+ * of right is at most j + b - a and left holds on [j, k). So every interval
+ * [s, e) of right is extended backwards to the latest of the end of the
+ * previous interval of right, the start of the interval of left that reaches
+ * s, and s - (b - a), then shifted by a.
+ */
+IntervalSet until(const IntervalSet &left, const IntervalSet &right, size_t a,
+                  size_t b) {
+  IntervalSet result;
+  if (b < a) {
+    return result;
+  }
+  size_t width = b - a;
+  size_t previous_end = 0;
+  size_t l = 0;
+  for (size_t k = 0; k < right.num_intervals(); ++k) {
+    size_t s = right.begin(k), e = right.end(k);
+    size_t j = s;
+    if (s > 0) {
+      // the interval of left containing s - 1, if any
+      while (l < left.num_intervals() && left.end(l) < s) {
+        ++l;
+      }
+      if (l < left.num_intervals() && left.begin(l) < s) {
+        j = left.begin(l);
+      }
+    }
+    j = max({j, previous_end, s > width ? s - width : 0});
+    previous_end = e;
+    if (e > max(j, a)) {
+      result.push_back(max(j, a) - a, e - a);
+    }
+  }
+  return result;
+}
+
+IntervalSet evaluate_intervals(const ASTNode &formula,
+                               const IntervalTrace &trace) {
+  size_t n = trace.size();
+  switch (formula.get_type()) {
+  case ASTNode::Type::Constant: {
+    IntervalSet result;
+    if (static_cast<const Constant &>(formula).get_value()) {
+      result.push_back(0, n);
+    }
+    return result;
+  }
+  case ASTNode::Type::Variable: {
+    unsigned int id = static_cast<const Variable &>(formula).get_id();
+    return id < trace.num_vars() ? trace.get_variable(id) : IntervalSet();
+  }
+  case ASTNode::Type::Negation:
+    return complement(
+        evaluate_intervals(static_cast<const UnaryOp &>(formula).get_operand(),
+                           trace),
+        n);
+  case ASTNode::Type::Finally:
+  case ASTNode::Type::Globally: {
+    const UnaryTempOp &op = static_cast<const UnaryTempOp &>(formula);
+    size_t a = op.get_lower_bound(), b = op.get_upper_bound();
+    IntervalSet operand = evaluate_intervals(op.get_operand(), trace);
+    if (formula.get_type() == ASTNode::Type::Finally) {
+      return shift_window(operand, a, b);
+    }
+    // G[a,b] p == ~F[a,b] ~p, also where the window is cut short
+    return complement(shift_window(complement(operand, n), a, b), n);
+  }
+  default:
+    break;
+  }
+
+  const BinaryOp &op = static_cast<const BinaryOp &>(formula);
+  IntervalSet left = evaluate_intervals(op.get_left(), trace);
+  IntervalSet right = evaluate_intervals(op.get_right(), trace);
+  switch (formula.get_type()) {
+  case ASTNode::Type::And:
+    return merge(left, right, [](bool l, bool r) { return l && r; });
+  case ASTNode::Type::Xor:
+    return merge(left, right, [](bool l, bool r) { return l != r; });
+  case ASTNode::Type::Or:
+    return merge(left, right, [](bool l, bool r) { return l || r; });
+  case ASTNode::Type::Implies:
+    return complement(
+        merge(left, right, [](bool l, bool r) { return l && !r; }), n);
+  case ASTNode::Type::Equiv:
+    return complement(
+        merge(left, right, [](bool l, bool r) { return l != r; }), n);
+  case ASTNode::Type::Until: {
+    const BinaryTempOp &temp_op = static_cast<const BinaryTempOp &>(formula);
+    return until(left, right, temp_op.get_lower_bound(),
+                 temp_op.get_upper_bound());
+  }
+  default: { // ASTNode::Type::Release
+    const BinaryTempOp &temp_op = static_cast<const BinaryTempOp &>(formula);
+    size_t a = temp_op.get_lower_bound(), b = temp_op.get_upper_bound();
+    IntervalSet result;
+    if (b < a) {
+      // see window_release in kernels.cc
+      result.push_back((b + 1 == a) ? 0 : n - min(a, n), n);
+      return result;
+    }
+    // l R[a,b] r == ~(~l U[a,b] ~r)
+    return complement(until(complement(left, n), complement(right, n), a, b),
+                      n);
+  }
+  }
+}
+
+} // namespace libmltl
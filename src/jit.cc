@@ -0,0 +1,394 @@
+#include "jit.hh"
+
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <dlfcn.h>
+#include <fcntl.h>
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <pwd.h>
+#include <sstream>
+#include <stdexcept>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+using namespace std;
+namespace libmltl {
+
+/* Bumped whenever the generated code changes, so stale cache entries are not
+ * loaded.
+ */
+const char *const jit_version = "libmltl-jit-1";
+
+string size_literal(size_t value) { return to_string(value) + "ul"; }
+
+/* Index expression i + offset.
+ */
+string position(size_t offset) {
+  return offset ? "i + " + size_literal(offset) : "i";
+}
+
+/* Emits the loop over the window [i+lb, min(i+ub, n-1)] of a temporal
+ * operator. step is the code run for position k (as "@"); it returns early
+ * once the verdict is known, otherwise the function returns fallthrough.
+ */
+string emit_window(size_t lb, size_t ub, const string &step,
+                   const string &fallthrough) {
+  string code = "  const size_t end = min_(i + " + size_literal(ub) +
+                " + 1, c.n);\n";
+  auto instantiate = [&](const string &k) {
+    string result = step;
+    for (size_t pos; (pos = result.find('@')) != string::npos;) {
+      result.replace(pos, 1, k);
+    }
+    return result;
+  };
+  if (ub >= lb && ub - lb < jit_unroll_limit) {
+    for (size_t k = lb; k <= ub; ++k) {
+      code += "  if (" + position(k) + " >= end) {\n    return " +
+              fallthrough + ";\n  }\n";
+      code += instantiate(position(k));
+    }
+  } else {
+    code += "  for (size_t k = " + position(lb) + "; k < end; ++k) {\n";
+    string body = instantiate("k");
+    for (size_t pos = 0; pos < body.size(); pos = body.find('\n', pos) + 1) {
+      body.insert(pos, "  ");
+    }
+    code += body + "  }\n";
+  }
+  return code + "  return " + fallthrough + ";\n";
+}
+
+/* Emits the function evaluating formula, unless an equal subformula already
+ * has one, and returns its name.
+ */
+string emit_function(const ASTNode &formula, map<string, string> &names,
+                     string &code) {
+  string key = formula.as_string();
+  auto it = names.find(key);
+  if (it != names.end()) {
+    return it->second;
+  }
+  string left, right;
+  if (formula.is_unary_op()) {
+    left = emit_function(static_cast<const UnaryOp &>(formula).get_operand(),
+                         names, code);
+  } else if (formula.is_binary_op()) {
+    const BinaryOp &op = static_cast<const BinaryOp &>(formula);
+    left = emit_function(op.get_left(), names, code);
+    right = emit_function(op.get_right(), names, code);
+  }
+  string l = left + "(c, i)";
+  string r = right + "(c, i)";
+  string body;
+  switch (formula.get_type()) {
+  case ASTNode::Type::Constant:
+    body = string("  return ") +
+           (static_cast<const Constant &>(formula).get_value() ? "true"
+                                                               : "false") +
+           ";\n";
+    break;
+  case ASTNode::Type::Variable: {
+    string id = to_string(static_cast<const Variable &>(formula).get_id());
+    body = "  return i < c.n && " + id + " < c.num_vars &&\n" +
+           "         ((c.columns[" + id + "][i >> 6] >> (i & 63)) & 1);\n";
+    break;
+  }
+  case ASTNode::Type::Negation:
+    body = "  return !" + l + ";\n";
+    break;
+  case ASTNode::Type::And:
+    body = "  return " + l + " && " + r + ";\n";
+    break;
+  case ASTNode::Type::Xor:
+    body = "  return " + l + " != " + r + ";\n";
+    break;
+  case ASTNode::Type::Or:
+    body = "  return " + l + " || " + r + ";\n";
+    break;
+  case ASTNode::Type::Implies:
+    body = "  return !" + l + " || " + r + ";\n";
+    break;
+  case ASTNode::Type::Equiv:
+    body = "  return " + l + " == " + r + ";\n";
+    break;
+  case ASTNode::Type::Finally:
+  case ASTNode::Type::Globally: {
+    const UnaryTempOp &op = static_cast<const UnaryTempOp &>(formula);
+    bool finally = formula.get_type() == ASTNode::Type::Finally;
+    string truncated = finally ? "false" : "true";
+    body = "  if (c.n - i <= " + size_literal(op.get_lower_bound()) +
+           ") {\n    return " + truncated + ";\n  }\n";
+    string step =
+        finally ? "  if (" + left + "(c, @)) {\n    return true;\n  }\n"
+                : "  if (!" + left + "(c, @)) {\n    return false;\n  }\n";
+    body += emit_window(op.get_lower_bound(), op.get_upper_bound(), step,
+                        truncated);
+    break;
+  }
+  case ASTNode::Type::Until: {
+    // the first witness of right decides, left must hold before it
+    const BinaryTempOp &op = static_cast<const BinaryTempOp &>(formula);
+    body = "  if (c.n - i <= " + size_literal(op.get_lower_bound()) +
+           ") {\n    return false;\n  }\n";
+    string step = "  if (" + right + "(c, @)) {\n    return true;\n  }\n" +
+                  "  if (!" + left + "(c, @)) {\n    return false;\n  }\n";
+    body += emit_window(op.get_lower_bound(), op.get_upper_bound(), step,
+                        "false");
+    break;
+  }
+  case ASTNode::Type::Release: {
+    // right must hold until (and including where) left releases it
+    const BinaryTempOp &op = static_cast<const BinaryTempOp &>(formula);
+    size_t lb = op.get_lower_bound();
+    size_t ub = op.get_upper_bound();
+    body = "  if (c.n - i <= " + size_literal(lb) +
+           ") {\n    return true;\n  }\n";
+    if (ub < lb) {
+      // see window_release in kernels.cc
+      body += string("  return ") + (ub + 1 == lb ? "true" : "false") + ";\n";
+      break;
+    }
+    string step = "  if (!" + right + "(c, @)) {\n    return false;\n  }\n" +
+                  "  if (" + left + "(c, @)) {\n    return true;\n  }\n";
+    body += emit_window(lb, ub, step, "true");
+    break;
+  }
+  }
+  string name = "f" + to_string(names.size());
+  code += "// " + key + "\nstatic bool " + name +
+          "(const Context &c, size_t i) {\n" + body + "}\n\n";
+  names.emplace(key, name);
+  return name;
+}
+
+string JitFormula::generate_source(const ASTNode &formula) {
+  string code = string("// generated by ") + jit_version + "\n" +
+                "#include <cstddef>\n"
+                "#include <cstdint>\n\n"
+                "struct Context {\n"
+                "  const uint64_t *const *columns;\n"
+                "  size_t num_vars;\n"
+                "  size_t n;\n"
+                "};\n\n"
+                "static inline size_t min_(size_t a, size_t b) {\n"
+                "  return a < b ? a : b;\n"
+                "}\n\n";
+  map<string, string> names;
+  string root = emit_function(formula, names, code);
+  code += "extern \"C\" const char libmltl_jit_formula[] = \"" +
+          formula.as_string() + "\";\n\n" +
+          "extern \"C\" bool libmltl_jit_evaluate(\n" +
+          "    const uint64_t *const *columns, size_t num_vars, size_t n) {\n" +
+          "  return " + root + "(Context{columns, num_vars, n}, 0);\n}\n";
+  return code;
+}
+
+string JitFormula::jit_cache_dir() {
+  const char *dir = getenv("LIBMLTL_JIT_CACHE");
+  if (dir != nullptr && *dir != '\0') {
+    return dir;
+  }
+  const char *cache = getenv("XDG_CACHE_HOME");
+  if (cache != nullptr && *cache == '/') {
+    return string(cache) + "/libmltl-jit";
+  }
+  const char *home = getenv("HOME");
+  if (home == nullptr || *home == '\0') {
+    const passwd *entry = getpwuid(geteuid());
+    home = entry != nullptr ? entry->pw_dir : nullptr;
+  }
+  if (home == nullptr || *home == '\0') {
+    throw runtime_error("no cache directory for JIT compiled formulas, set "
+                        "LIBMLTL_JIT_CACHE");
+  }
+  return string(home) + "/.cache/libmltl-jit";
+}
+
+/* Whether path is owned by the effective user and writable by nobody else,
+ * so that no other user can have placed or changed what is there.
+ */
+bool owned_privately(const struct stat &info) {
+  return info.st_uid == geteuid() && (info.st_mode & (S_IWGRP | S_IWOTH)) == 0;
+}
+
+/* Creates dir (mode 0700) and its parents if missing. Returns whether dir is
+ * a directory that only the effective user can write to.
+ */
+bool make_private_directory(const string &dir) {
+  filesystem::path path(dir);
+  if (path.has_parent_path()) {
+    error_code error;
+    filesystem::create_directories(path.parent_path(), error);
+  }
+  if (mkdir(dir.c_str(), 0700) != 0 && errno != EEXIST) {
+    return false;
+  }
+  struct stat info;
+  return stat(dir.c_str(), &info) == 0 && S_ISDIR(info.st_mode) &&
+         owned_privately(info);
+}
+
+/* Runs the C++ compiler on source without a shell, so that no path needs
+ * quoting. $LIBMLTL_JIT_CXX is split at whitespace, so it may add options.
+ * Returns whether the compiler succeeded; its messages go to log.
+ */
+bool compile(const string &source, const string &object, const string &log) {
+  const char *cxx = getenv("LIBMLTL_JIT_CXX");
+  vector<string> args;
+  istringstream words(cxx != nullptr ? cxx : "");
+  for (string word; words >> word;) {
+    args.push_back(word);
+  }
+  if (args.empty()) {
+    args.push_back("g++");
+  }
+  for (const char *arg : {"-std=c++17", "-O2", "-shared", "-fPIC", "-o"}) {
+    args.push_back(arg);
+  }
+  args.push_back(object);
+  args.push_back(source);
+  vector<char *> argv;
+  for (string &arg : args) {
+    argv.push_back(arg.data());
+  }
+  argv.push_back(nullptr);
+
+  int log_fd = open(log.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0600);
+  if (log_fd < 0) {
+    return false;
+  }
+  pid_t pid = fork();
+  if (pid == 0) {
+    dup2(log_fd, STDERR_FILENO);
+    execvp(argv[0], argv.data());
+    perror(argv[0]);
+    _exit(127);
+  }
+  close(log_fd);
+  int status = 0;
+  while (pid > 0 && waitpid(pid, &status, 0) < 0 && errno == EINTR) {
+  }
+  return pid > 0 && WIFEXITED(status) && WEXITSTATUS(status) == 0;
+}
+
+JitFormula::JitFormula(const ASTNode &formula, const string &cache_dir)
+    : formula(formula.as_string()), handle(nullptr), function(nullptr),
+      cached(true) {
+  // FNV-1a, stable across processes and standard library versions
+  uint64_t hash = 0xcbf29ce484222325;
+  for (const string &part : {string(jit_version), this->formula}) {
+    for (unsigned char ch : part) {
+      hash = (hash ^ ch) * 0x100000001b3;
+    }
+  }
+  char hex[17];
+  snprintf(hex, sizeof(hex), "%016llx", (unsigned long long)hash);
+  // a cache that other users can write to may hold objects they planted, so
+  // it is neither loaded from nor written to: the formula is compiled in a
+  // fresh private directory that is removed again once the object is loaded
+  string dir = cache_dir;
+  bool shared = !make_private_directory(cache_dir);
+  if (shared) {
+    string pattern =
+        (filesystem::temp_directory_path() / "libmltl-jit-XXXXXX").string();
+    if (mkdtemp(pattern.data()) == nullptr) {
+      throw runtime_error("cannot create a directory to JIT compile " +
+                          this->formula);
+    }
+    dir = pattern;
+  }
+  string base = dir + "/" + hex;
+  if (!shared && load(base + ".so")) {
+    return;
+  }
+
+  // compile under names private to this process and move the results into
+  // place, so concurrent processes never load a partially written object
+  cached = false;
+  string tmp = base + "." + to_string(getpid());
+  ofstream(tmp + ".cc") << generate_source(formula);
+  if (!compile(tmp + ".cc", tmp + ".so", tmp + ".log")) {
+    throw runtime_error("JIT compilation of " + this->formula +
+                        " failed, see " + tmp + ".log");
+  }
+  filesystem::remove(tmp + ".log");
+  filesystem::rename(tmp + ".cc", base + ".cc");
+  filesystem::rename(tmp + ".so", base + ".so");
+  bool loaded = load(base + ".so");
+  if (shared) {
+    filesystem::remove_all(dir);
+  }
+  if (!loaded) {
+    throw runtime_error("cannot load JIT compiled " + base + ".so");
+  }
+}
+
+bool JitFormula::load(const string &path) {
+  // only objects this user wrote, and nobody else can have changed since
+  struct stat info;
+  if (lstat(path.c_str(), &info) != 0 || !S_ISREG(info.st_mode) ||
+      !owned_privately(info)) {
+    return false;
+  }
+  void *h = dlopen(path.c_str(), RTLD_NOW | RTLD_LOCAL);
+  if (h == nullptr) {
+    return false;
+  }
+  const char *name =
+      reinterpret_cast<const char *>(dlsym(h, "libmltl_jit_formula"));
+  EvaluateFunction f =
+      reinterpret_cast<EvaluateFunction>(dlsym(h, "libmltl_jit_evaluate"));
+  // a hash collision or a stale object
+  if (name == nullptr || f == nullptr || formula != name) {
+    dlclose(h);
+    return false;
+  }
+  handle = h;
+  function = f;
+  return true;
+}
+
+JitFormula::JitFormula(JitFormula &&other) noexcept
+    : formula(std::move(other.formula)), handle(other.handle),
+      function(other.function), cached(other.cached) {
+  other.handle = nullptr;
+  other.function = nullptr;
+}
+JitFormula &JitFormula::operator=(JitFormula &&other) noexcept {
+  if (this != &other) {
+    if (handle != nullptr) {
+      dlclose(handle);
+    }
+    formula = std::move(other.formula);
+    handle = other.handle;
+    function = other.function;
+    cached = other.cached;
+    other.handle = nullptr;
+    other.function = nullptr;
+  }
+  return *this;
+}
+JitFormula::~JitFormula() {
+  if (handle != nullptr) {
+    dlclose(handle);
+  }
+}
+
+bool JitFormula::evaluate(const Trace &trace) const {
+  thread_local vector<const uint64_t *> columns;
+  columns.resize(trace.num_vars());
+  for (unsigned int id = 0; id < trace.num_vars(); ++id) {
+    columns[id] = trace.get_variable(id).data();
+  }
+  return function(columns.data(), trace.num_vars(), trace.size());
+}
+bool JitFormula::evaluate(const vector<string> &trace) const {
+  return evaluate(Trace(trace));
+}
+
+} // namespace libmltl
@@ -0,0 +1,722 @@
+#include "kernels.hh"
+
+#include <algorithm>
+#include <atomic>
+
+#if defined(__x86_64__) || defined(__i386__)
+#define LIBMLTL_X86 1
+#include <immintrin.h>
+#endif
+
+using namespace std;
+namespace libmltl {
+
+/* dst[w] |= (src >> k)[w] for every word, where src >> k moves bit i + k to bit
+ * i and shifts in zeros past the end. Words are processed in increasing order
+ * and only words at or after w are read, so dst may alias src.
+ */
+void shift_or(uint64_t *dst, const uint64_t *src, size_t num_words, size_t k,
+              bool overwrite = false) {
+  size_t q = k >> 6;
+  size_t r = k & 63;
+  for (size_t w = 0; w < num_words; ++w) {
+    uint64_t lo = (w + q < num_words) ? src[w + q] : 0;
+    uint64_t hi = (w + q + 1 < num_words) ? src[w + q + 1] : 0;
+    uint64_t shifted = r ? (lo >> r) | (hi << (64 - r)) : lo;
+    dst[w] = overwrite ? shifted : (dst[w] | shifted);
+  }
+}
+
+/* Replaces bit i of words with the OR of bits [i, i+width-1], for width <= 64.
+ * Each word only needs its own bits and those of the next word, so the
+ * doubling steps are done in registers in one pass over memory.
+ */
+void fold_narrow(uint64_t *words, size_t num_words, size_t width) {
+  for (size_t w = 0; w < num_words; ++w) {
+    uint64_t lo = words[w];
+    uint64_t hi = (w + 1 < num_words) ? words[w + 1] : 0;
+    for (size_t covered = 1; covered < width;) {
+      size_t s = min(covered, width - covered);
+      lo |= (lo >> s) | (hi << (64 - s));
+      hi |= hi >> s;
+      covered += s;
+    }
+    words[w] = lo;
+  }
+}
+
+/* Computes result[i] = OR of src[i+lb .. i+ub], with bits past the end of src
+ * read as zero.
+ */
+void window_or(uint64_t *result, const uint64_t *src, size_t num_words,
+               size_t n, size_t lb, size_t ub) {
+  shift_or(result, src, num_words, lb, true);
+  // bits past the end are zero, so the window never needs to exceed n
+  size_t width = min(ub - lb, n) + 1;
+  size_t covered = min(width, (size_t)64);
+  fold_narrow(result, num_words, covered);
+  while (covered < width) {
+    size_t s = min(covered, width - covered);
+    shift_or(result, result, num_words, s);
+    covered += s;
+  }
+}
+
+void clear_padding(uint64_t *words, size_t n) {
+  if (n & 63) {
+    words[n >> 6] &= ((uint64_t)1 << (n & 63)) - 1;
+  }
+}
+
+void window_any(uint64_t *dst, const uint64_t *src, size_t n, size_t lb,
+                size_t ub) {
+  size_t num_words = (n + 63) / 64;
+  if (lb >= n || ub < lb) {
+    fill_n(dst, num_words, 0);
+    return;
+  }
+  window_or(dst, src, num_words, n, lb, ub);
+  clear_padding(dst, n);
+}
+
+void window_all(uint64_t *dst, const uint64_t *src, size_t n, size_t lb,
+                size_t ub) {
+  size_t num_words = (n + 63) / 64;
+  if (lb >= n || ub < lb) {
+    fill_n(dst, num_words, ~(uint64_t)0);
+    clear_padding(dst, n);
+    return;
+  }
+  // G[lb,ub] p == ~F[lb,ub] ~p, where the padding of ~p must stay zero
+  bitwise_not(dst, src, num_words);
+  clear_padding(dst, n);
+  window_or(dst, dst, num_words, n, lb, ub);
+  bitwise_not(dst, dst, num_words);
+  clear_padding(dst, n);
+}
+
+/* Word w of src >> k, with zeros shifted in past the end.
+ */
+inline uint64_t shifted_word(const uint64_t *src, size_t num_words, size_t w,
+                             size_t k) {
+  size_t q = k >> 6;
+  size_t r = k & 63;
+  uint64_t lo = (w + q < num_words) ? src[w + q] : 0;
+  uint64_t hi = (w + q + 1 < num_words) ? src[w + q + 1] : 0;
+  return r ? (lo >> r) | (hi << (64 - r)) : lo;
+}
+
+/* Bit i of dst is set iff some k in [i+lb, min(i+ub, n-1)] has right[k] set
+ * and left set on [i+lb, k), with both operands complemented first if
+ * complement is set.
+ *
+ * A segment of positions is summarised by (all, any): left holds on all of
+ * it, and right holds somewhere in it with left holding before. Summaries of
+ * adjacent segments concatenate associatively,
+ *   (all1, any1) . (all2, any2) = (all1 & all2, any1 | (all1 & any2)),
+ * so like window_or the summaries of segments of length 2^j starting at every
+ * position are built by doubling, and the window is the concatenation of
+ * those for the bits of its width: O(n/64 * log(ub-lb+1)) word operations.
+ * Positions past the end read as false on both sides, which gives the
+ * truncated semantics.
+ */
+void until_words(uint64_t *dst, const uint64_t *left, const uint64_t *right,
+                 size_t n, size_t lb, size_t ub, bool complement) {
+  size_t num_words = (n + 63) / 64;
+  uint64_t flip = complement ? ~(uint64_t)0 : 0;
+  // short vectors, as in the prefixes evaluated by CompiledFormula, are kept
+  // on the stack
+  uint64_t small_buffer[3 * 8];
+  vector<uint64_t> buffer;
+  uint64_t *all = small_buffer;
+  if (num_words > 8) {
+    buffer.resize(3 * num_words);
+    all = buffer.data();
+  }
+  uint64_t *any = all + num_words;
+  uint64_t *acc_all = any + num_words;
+  for (size_t w = 0; w < num_words; ++w) {
+    all[w] = left[w] ^ flip;
+    any[w] = right[w] ^ flip;
+  }
+  clear_padding(all, n);
+  clear_padding(any, n);
+  // summaries of the segments of length 1 starting at i + lb
+  shift_or(all, all, num_words, lb, true);
+  shift_or(any, any, num_words, lb, true);
+  fill_n(dst, num_words, 0);
+  fill_n(acc_all, num_words, ~(uint64_t)0);
+
+  size_t width = min(ub - lb, n) + 1;
+  size_t len = 0; // length of the segments summarised by acc_all and dst
+  for (size_t s = 1; s <= width; s <<= 1) {
+    if (width & s) {
+      for (size_t w = 0; w < num_words; ++w) {
+        dst[w] |= acc_all[w] & shifted_word(any, num_words, w, len);
+        acc_all[w] &= shifted_word(all, num_words, w, len);
+      }
+      len += s;
+    }
+    if (s > width - s) {
+      break;
+    }
+    // segments of length 2s, updated in place: only words at or after w
+    // are read, and those still hold the summaries of length s
+    for (size_t w = 0; w < num_words; ++w) {
+      uint64_t new_any = any[w] | (all[w] & shifted_word(any, num_words, w, s));
+      all[w] &= shifted_word(all, num_words, w, s);
+      any[w] = new_any;
+    }
+  }
+  clear_padding(dst, n);
+}
+
+void window_until(uint64_t *dst, const uint64_t *left, const uint64_t *right,
+                  size_t n, size_t lb, size_t ub) {
+  if (ub < lb || lb >= n) {
+    fill_n(dst, (n + 63) / 64, 0);
+    return;
+  }
+  until_words(dst, left, right, n, lb, ub, false);
+}
+
+void window_release(uint64_t *dst, const uint64_t *left, const uint64_t *right,
+                    size_t n, size_t lb, size_t ub) {
+  size_t num_words = (n + 63) / 64;
+  if (lb >= n || ub < lb) {
+    fill_n(dst, num_words, ~(uint64_t)0);
+    if (ub < lb && ub + 1 != lb) {
+      // evaluate_subt accepts the empty window [lb, lb-1] as right holding on
+      // all of it, but finds no witness in any other empty window and fails
+      for (size_t i = 0; i + lb < n; ++i) {
+        dst[i >> 6] &= ~((uint64_t)1 << (i & 63));
+      }
+    }
+    clear_padding(dst, n);
+    return;
+  }
+  // l R[lb,ub] r == ~(~l U[lb,ub] ~r)
+  until_words(dst, left, right, n, lb, ub, true);
+  bitwise_not(dst, dst, num_words);
+  clear_padding(dst, n);
+}
+
+BitVector window_any(const BitVector &operand, size_t lb, size_t ub) {
+  BitVector result(operand.size());
+  window_any(result.data(), operand.data(), operand.size(), lb, ub);
+  return result;
+}
+
+BitVector window_all(const BitVector &operand, size_t lb, size_t ub) {
+  BitVector result(operand.size());
+  window_all(result.data(), operand.data(), operand.size(), lb, ub);
+  return result;
+}
+
+BitVector window_until(const BitVector &left, const BitVector &right,
+                       size_t lb, size_t ub) {
+  BitVector result(left.size());
+  window_until(result.data(), left.data(), right.data(), left.size(), lb, ub);
+  return result;
+}
+
+BitVector window_release(const BitVector &left, const BitVector &right,
+                         size_t lb, size_t ub) {
+  BitVector result(left.size());
+  window_release(result.data(), left.data(), right.data(), left.size(), lb,
+                 ub);
+  return result;
+}
+
+/* Words per tile of the fused kernels, 16 KiB per vector, unless the windows
+ * are so wide that the positions read past a tile would dominate.
+ */
+constexpr size_t fused_tile_words = 2048;
+
+/* dst = outer(inner(operands)) tile by tile. inner(mid, w0, n_in) computes the
+ * inner window over the operands from word w0 on, cut to n_in bits, into mid;
+ * outer(out, mid, w0, n_mid) the outer window over mid. The inner result is
+ * exact on a tile and the outer_ub positions after it, since those read at
+ * most inner_ub positions further, and so is the outer result on the tile.
+ */
+template <typename Inner, typename Outer>
+void fused_tiles(uint64_t *dst, size_t n, size_t outer_ub, size_t inner_ub,
+                 Inner inner, Outer outer) {
+  size_t num_words = (n + 63) / 64;
+  size_t outer_words = min(num_words, outer_ub / 64 + 1);
+  size_t inner_words = min(num_words, inner_ub / 64 + 1);
+  size_t tile = max(fused_tile_words, 4 * (outer_words + inner_words));
+  vector<uint64_t> mid(tile + outer_words + inner_words);
+  vector<uint64_t> out(tile + outer_words);
+  for (size_t w0 = 0; w0 < num_words; w0 += tile) {
+    size_t w1 = min(num_words, w0 + tile);
+    size_t in_end = min(num_words, w1 + outer_words + inner_words);
+    size_t n_in = min(n, in_end * 64) - w0 * 64;
+    inner(mid.data(), w0, n_in);
+    // cut at a word boundary, or at the end of the trace, so the padding of
+    // mid is zero
+    size_t mid_end = min(num_words, w1 + outer_words);
+    size_t n_mid = min(n_in, (mid_end - w0) * 64);
+    outer(out.data(), mid.data(), w0, n_mid);
+    copy_n(out.data(), w1 - w0, dst + w0);
+  }
+}
+
+/* Windows of at most 64 positions are computed one word at a time in
+ * registers: word w of the result only depends on the words w + lb/64 to
+ * w + lb/64 + 2 of the operands, which the caller passes in. The fused kernels
+ * feed the words of the inner window straight into the outer one this way,
+ * in a single pass over the trace. Away from the end of the trace (unless
+ * checked) every bit read is inside it, which saves the bounds checks.
+ */
+bool is_narrow(size_t lb, size_t ub) { return lb <= ub && ub - lb < 64; }
+
+/* The bits b of word w with 64w + b + k < n.
+ */
+inline uint64_t valid_bits(size_t n, size_t w, size_t k) {
+  size_t first = w * 64 + k;
+  if (first >= n) {
+    return 0;
+  }
+  return (n - first >= 64) ? ~(uint64_t)0 : ((uint64_t)1 << (n - first)) - 1;
+}
+
+/* Bits [k, k + 64) of the 128 bits lo:hi, for k < 64.
+ */
+inline uint64_t funnel(uint64_t lo, uint64_t hi, size_t k) {
+  return k ? (lo >> k) | (hi << (64 - k)) : lo;
+}
+
+/* Word w of F[lb,ub] operand, or of G[lb,ub] operand if all, from the words
+ * x[0..2] = w + lb/64 .. w + lb/64 + 2 of the operand. Like fold_narrow, the
+ * window is folded over the shifted word and the next one.
+ */
+inline uint64_t narrow_window_word(const uint64_t x[3], size_t n, size_t w,
+                                   size_t lb, size_t ub, bool all,
+                                   bool checked) {
+  size_t r = lb & 63;
+  uint64_t lo = funnel(x[0], x[1], r);
+  uint64_t hi = funnel(x[1], x[2], r);
+  if (all) {
+    // G[lb,ub] p == ~F[lb,ub] ~p, where ~p is zero past the end
+    lo = ~lo;
+    hi = ~hi;
+    if (checked) {
+      lo &= valid_bits(n, w, lb);
+      hi &= valid_bits(n, w + 1, lb);
+    }
+  }
+  size_t width = ub - lb + 1;
+  for (size_t covered = 1; covered < width;) {
+    // 0 < s < 64
+    size_t s = min(covered, width - covered);
+    lo |= (lo >> s) | (hi << (64 - s));
+    hi |= hi >> s;
+    covered += s;
+  }
+  if (all) {
+    lo = ~lo;
+  }
+  return checked ? lo & valid_bits(n, w, 0) : lo;
+}
+
+/* Word w of left U[lb,ub] right from the words w + lb/64 .. w + lb/64 + 2 of
+ * left (l) and right (r), with the doubling of until_words done on two words
+ * in registers. A summary in the second word is wrong where its segment runs
+ * past it, but the window only reads segments ending within 63 positions of
+ * the first word.
+ */
+inline uint64_t narrow_until_word(const uint64_t l[3], const uint64_t r[3],
+                                  size_t n, size_t w, size_t lb, size_t ub,
+                                  bool checked) {
+  size_t k = lb & 63;
+  uint64_t all_lo = funnel(l[0], l[1], k), all_hi = funnel(l[1], l[2], k);
+  uint64_t any_lo = funnel(r[0], r[1], k), any_hi = funnel(r[1], r[2], k);
+  uint64_t result = 0, acc_all = ~(uint64_t)0;
+  size_t width = ub - lb + 1;
+  size_t len = 0;
+  for (size_t s = 1; s <= width; s <<= 1) {
+    if (width & s) {
+      result |= acc_all & funnel(any_lo, any_hi, len);
+      acc_all &= funnel(all_lo, all_hi, len);
+      len += s;
+    }
+    if (s > width - s) {
+      break;
+    }
+    any_lo |= all_lo & funnel(any_lo, any_hi, s);
+    any_hi |= all_hi & (any_hi >> s);
+    all_lo &= funnel(all_lo, all_hi, s);
+    all_hi &= all_hi >> s;
+  }
+  return checked ? result & valid_bits(n, w, 0) : result;
+}
+
+/* Words v + lb/64 .. v + lb/64 + 2 of src, zero past the end if checked.
+ */
+inline void operand_words(uint64_t x[3], const uint64_t *src,
+                          size_t num_words, size_t v, size_t lb,
+                          bool checked) {
+  size_t q = v + (lb >> 6);
+  for (size_t i = 0; i < 3; ++i) {
+    x[i] = (!checked || q + i < num_words) ? src[q + i] : 0;
+  }
+}
+
+/* dst = outer(inner) for narrow windows [lb1, ub1] over [lb2, ub2] in one
+ * pass. inner(v, checked) is word v of the inner result, called once for
+ * every v in increasing order; outer(w, x, checked) word w of the outer
+ * result from the inner words x[0..2] = w + lb1/64 .. w + lb1/64 + 2.
+ */
+template <typename Inner, typename Outer>
+void fused_words(uint64_t *dst, size_t n, size_t lb1, size_t lb2, Inner inner,
+                 Outer outer) {
+  size_t num_words = (n + 63) / 64;
+  size_t q = lb1 >> 6;
+  // words whose operands and inner words all lie in full words of the trace
+  size_t margin = q + (lb2 >> 6) + 6;
+  size_t interior = (n / 64 > margin) ? n / 64 - margin : 0;
+  auto word = [&](size_t v) { return v < num_words ? inner(v, true) : 0; };
+  uint64_t x[3] = {0, word(q), word(q + 1)};
+  size_t w = 0;
+  for (; w < interior; ++w) {
+    x[0] = x[1];
+    x[1] = x[2];
+    x[2] = inner(w + q + 2, false);
+    dst[w] = outer(w, x, false);
+  }
+  for (; w < num_words; ++w) {
+    x[0] = x[1];
+    x[1] = x[2];
+    x[2] = word(w + q + 2);
+    dst[w] = outer(w, x, true);
+  }
+}
+
+void window_any_all(uint64_t *dst, const uint64_t *src, size_t n, size_t lb1,
+                    size_t ub1, size_t lb2, size_t ub2) {
+  size_t num_words = (n + 63) / 64;
+  if (is_narrow(lb1, ub1) && is_narrow(lb2, ub2)) {
+    fused_words(
+        dst, n, lb1, lb2,
+        [&](size_t v, bool checked) {
+          uint64_t x[3];
+          operand_words(x, src, num_words, v, lb2, checked);
+          return narrow_window_word(x, n, v, lb2, ub2, true, checked);
+        },
+        [&](size_t w, const uint64_t x[3], bool checked) {
+          return narrow_window_word(x, n, w, lb1, ub1, false, checked);
+        });
+    return;
+  }
+  fused_tiles(
+      dst, n, ub1, ub2,
+      [&](uint64_t *mid, size_t w0, size_t n_in) {
+        window_all(mid, src + w0, n_in, lb2, ub2);
+      },
+      [&](uint64_t *out, const uint64_t *mid, size_t, size_t n_mid) {
+        window_any(out, mid, n_mid, lb1, ub1);
+      });
+}
+
+void window_all_any(uint64_t *dst, const uint64_t *src, size_t n, size_t lb1,
+                    size_t ub1, size_t lb2, size_t ub2) {
+  size_t num_words = (n + 63) / 64;
+  if (is_narrow(lb1, ub1) && is_narrow(lb2, ub2)) {
+    fused_words(
+        dst, n, lb1, lb2,
+        [&](size_t v, bool checked) {
+          uint64_t x[3];
+          operand_words(x, src, num_words, v, lb2, checked);
+          return narrow_window_word(x, n, v, lb2, ub2, false, checked);
+        },
+        [&](size_t w, const uint64_t x[3], bool checked) {
+          return narrow_window_word(x, n, w, lb1, ub1, true, checked);
+        });
+    return;
+  }
+  fused_tiles(
+      dst, n, ub1, ub2,
+      [&](uint64_t *mid, size_t w0, size_t n_in) {
+        window_any(mid, src + w0, n_in, lb2, ub2);
+      },
+      [&](uint64_t *out, const uint64_t *mid, size_t, size_t n_mid) {
+        window_all(out, mid, n_mid, lb1, ub1);
+      });
+}
+
+void window_until_until(uint64_t *dst, const uint64_t *left,
+                        const uint64_t *mid, const uint64_t *right, size_t n,
+                        size_t lb1, size_t ub1, size_t lb2, size_t ub2) {
+  size_t num_words = (n + 63) / 64;
+  if (is_narrow(lb1, ub1) && is_narrow(lb2, ub2)) {
+    fused_words(
+        dst, n, lb1, lb2,
+        [&](size_t v, bool checked) {
+          uint64_t l[3], r[3];
+          operand_words(l, mid, num_words, v, lb2, checked);
+          operand_words(r, right, num_words, v, lb2, checked);
+          return narrow_until_word(l, r, n, v, lb2, ub2, checked);
+        },
+        [&](size_t w, const uint64_t x[3], bool checked) {
+          uint64_t l[3];
+          operand_words(l, left, num_words, w, lb1, checked);
+          return narrow_until_word(l, x, n, w, lb1, ub1, checked);
+        });
+    return;
+  }
+  fused_tiles(
+      dst, n, ub1, ub2,
+      [&](uint64_t *inner, size_t w0, size_t n_in) {
+        window_until(inner, mid + w0, right + w0, n_in, lb2, ub2);
+      },
+      [&](uint64_t *out, const uint64_t *inner, size_t w0, size_t n_mid) {
+        window_until(out, left + w0, inner, n_mid, lb1, ub1);
+      });
+}
+
+BitVector window_any_all(const BitVector &operand, size_t lb1, size_t ub1,
+                         size_t lb2, size_t ub2) {
+  BitVector result(operand.size());
+  window_any_all(result.data(), operand.data(), operand.size(), lb1, ub1, lb2,
+                 ub2);
+  return result;
+}
+
+BitVector window_all_any(const BitVector &operand, size_t lb1, size_t ub1,
+                         size_t lb2, size_t ub2) {
+  BitVector result(operand.size());
+  window_all_any(result.data(), operand.data(), operand.size(), lb1, ub1, lb2,
+                 ub2);
+  return result;
+}
+
+BitVector window_until_until(const BitVector &left, const BitVector &mid,
+                             const BitVector &right, size_t lb1, size_t ub1,
+                             size_t lb2, size_t ub2) {
+  BitVector result(left.size());
+  window_until_until(result.data(), left.data(), mid.data(), right.data(),
+                     left.size(), lb1, ub1, lb2, ub2);
+  return result;
+}
+
+/* Each operator provides a scalar implementation and, on x86, AVX2 and
+ * AVX-512 ones. The vector versions are compiled for their target with
+ * function attributes and only called after checking the CPU at runtime.
+ */
+struct NotOp {
+  static uint64_t scalar(uint64_t a, [[maybe_unused]] uint64_t b) {
+    return ~a;
+  }
+#if LIBMLTL_X86
+  __attribute__((target("avx2"))) static __m256i
+  avx2(__m256i a, [[maybe_unused]] __m256i b) {
+    return _mm256_xor_si256(a, _mm256_set1_epi64x(-1));
+  }
+  __attribute__((target("avx512f"))) static __m512i
+  avx512(__m512i a, [[maybe_unused]] __m512i b) {
+    return _mm512_ternarylogic_epi64(a, a, a, 0x55); // ~a
+  }
+#endif
+};
+
+struct AndOp {
+  static uint64_t scalar(uint64_t a, uint64_t b) { return a & b; }
+#if LIBMLTL_X86
+  __attribute__((target("avx2"))) static __m256i avx2(__m256i a, __m256i b) {
+    return _mm256_and_si256(a, b);
+  }
+  __attribute__((target("avx512f"))) static __m512i avx512(__m512i a,
+                                                           __m512i b) {
+    return _mm512_and_si512(a, b);
+  }
+#endif
+};
+
+struct OrOp {
+  static uint64_t scalar(uint64_t a, uint64_t b) { return a | b; }
+#if LIBMLTL_X86
+  __attribute__((target("avx2"))) static __m256i avx2(__m256i a, __m256i b) {
+    return _mm256_or_si256(a, b);
+  }
+  __attribute__((target("avx512f"))) static __m512i avx512(__m512i a,
+                                                           __m512i b) {
+    return _mm512_or_si512(a, b);
+  }
+#endif
+};
+
+struct XorOp {
+  static uint64_t scalar(uint64_t a, uint64_t b) { return a ^ b; }
+#if LIBMLTL_X86
+  __attribute__((target("avx2"))) static __m256i avx2(__m256i a, __m256i b) {
+    return _mm256_xor_si256(a, b);
+  }
+  __attribute__((target("avx512f"))) static __m512i avx512(__m512i a,
+                                                           __m512i b) {
+    return _mm512_xor_si512(a, b);
+  }
+#endif
+};
+
+struct ImpliesOp {
+  static uint64_t scalar(uint64_t a, uint64_t b) { return ~a | b; }
+#if LIBMLTL_X86
+  __attribute__((target("avx2"))) static __m256i avx2(__m256i a, __m256i b) {
+    return _mm256_or_si256(_mm256_xor_si256(a, _mm256_set1_epi64x(-1)), b);
+  }
+  __attribute__((target("avx512f"))) static __m512i avx512(__m512i a,
+                                                           __m512i b) {
+    return _mm512_ternarylogic_epi64(a, b, b, 0xcf); // ~a | b
+  }
+#endif
+};
+
+struct EquivOp {
+  static uint64_t scalar(uint64_t a, uint64_t b) { return ~(a ^ b); }
+#if LIBMLTL_X86
+  __attribute__((target("avx2"))) static __m256i avx2(__m256i a, __m256i b) {
+    return _mm256_xor_si256(_mm256_xor_si256(a, b), _mm256_set1_epi64x(-1));
+  }
+  __attribute__((target("avx512f"))) static __m512i avx512(__m512i a,
+                                                           __m512i b) {
+    return _mm512_ternarylogic_epi64(a, b, b, 0xc3); // ~(a ^ b)
+  }
+#endif
+};
+
+template <typename Op>
+void bulk_scalar(uint64_t *dst, const uint64_t *a, const uint64_t *b,
+                 size_t num_words) {
+  for (size_t w = 0; w < num_words; ++w) {
+    dst[w] = Op::scalar(a[w], b[w]);
+  }
+}
+
+#if LIBMLTL_X86
+template <typename Op>
+__attribute__((target("avx2"))) void bulk_avx2(uint64_t *dst,
+                                               const uint64_t *a,
+                                               const uint64_t *b,
+                                               size_t num_words) {
+  size_t w = 0;
+  for (; w + 4 <= num_words; w += 4) {
+    __m256i va = _mm256_loadu_si256((const __m256i *)(a + w));
+    __m256i vb = _mm256_loadu_si256((const __m256i *)(b + w));
+    _mm256_storeu_si256((__m256i *)(dst + w), Op::avx2(va, vb));
+  }
+  bulk_scalar<Op>(dst + w, a + w, b + w, num_words - w);
+}
+
+template <typename Op>
+__attribute__((target("avx512f"))) void bulk_avx512(uint64_t *dst,
+                                                    const uint64_t *a,
+                                                    const uint64_t *b,
+                                                    size_t num_words) {
+  size_t w = 0;
+  for (; w + 8 <= num_words; w += 8) {
+    __m512i va = _mm512_loadu_si512((const void *)(a + w));
+    __m512i vb = _mm512_loadu_si512((const void *)(b + w));
+    _mm512_storeu_si512((void *)(dst + w), Op::avx512(va, vb));
+  }
+  bulk_scalar<Op>(dst + w, a + w, b + w, num_words - w);
+}
+#endif
+
+SimdLevel supported_simd_level() {
+#if LIBMLTL_X86
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx512f")) {
+    return SimdLevel::AVX512;
+  }
+  if (__builtin_cpu_supports("avx2")) {
+    return SimdLevel::AVX2;
+  }
+#endif
+  return SimdLevel::Scalar;
+}
+
+/* Read by every bulk kernel call, also on pool threads, while
+ * set_simd_level may change it; relaxed is enough because the kernels for
+ * all levels give the same results.
+ */
+atomic<SimdLevel> &active_simd_level() {
+  static atomic<SimdLevel> level(supported_simd_level());
+  return level;
+}
+
+SimdLevel get_simd_level() {
+  return active_simd_level().load(memory_order_relaxed);
+}
+void set_simd_level(SimdLevel level) {
+  active_simd_level().store(min(level, supported_simd_level()),
+                            memory_order_relaxed);
+}
+
+template <typename Op>
+void bulk(uint64_t *dst, const uint64_t *a, const uint64_t *b,
+          size_t num_words) {
+#if LIBMLTL_X86
+  switch (active_simd_level().load(memory_order_relaxed)) {
+  case SimdLevel::AVX512:
+    bulk_avx512<Op>(dst, a, b, num_words);
+    return;
+  case SimdLevel::AVX2:
+    bulk_avx2<Op>(dst, a, b, num_words);
+    return;
+  default:
+    break;
+  }
+#endif
+  bulk_scalar<Op>(dst, a, b, num_words);
+}
+
+void bitwise_not(uint64_t *dst, const uint64_t *a, size_t num_words) {
+  bulk<NotOp>(dst, a, a, num_words);
+}
+void bitwise_and(uint64_t *dst, const uint64_t *a, const uint64_t *b,
+                 size_t num_words) {
+  bulk<AndOp>(dst, a, b, num_words);
+}
+void bitwise_or(uint64_t *dst, const uint64_t *a, const uint64_t *b,
+                size_t num_words) {
+  bulk<OrOp>(dst, a, b, num_words);
+}
+void bitwise_xor(uint64_t *dst, const uint64_t *a, const uint64_t *b,
+                 size_t num_words) {
+  bulk<XorOp>(dst, a, b, num_words);
+}
+void bitwise_implies(uint64_t *dst, const uint64_t *a, const uint64_t *b,
+                     size_t num_words) {
+  bulk<ImpliesOp>(dst, a, b, num_words);
+}
+void bitwise_equiv(uint64_t *dst, const uint64_t *a, const uint64_t *b,
+                   size_t num_words) {
+  bulk<EquivOp>(dst, a, b, num_words);
+}
+
+template <typename Op> BitVector bulk(const BitVector &a, const BitVector &b) {
+  BitVector result(a.size());
+  bulk<Op>(result.data(), a.data(), b.data(), result.num_words());
+  result.clear_padding();
+  return result;
+}
+
+BitVector bitwise_not(const BitVector &a) { return bulk<NotOp>(a, a); }
+BitVector bitwise_and(const BitVector &a, const BitVector &b) {
+  return bulk<AndOp>(a, b);
+}
+BitVector bitwise_or(const BitVector &a, const BitVector &b) {
+  return bulk<OrOp>(a, b);
+}
+BitVector bitwise_xor(const BitVector &a, const BitVector &b) {
+  return bulk<XorOp>(a, b);
+}
+BitVector bitwise_implies(const BitVector &a, const BitVector &b) {
+  return bulk<ImpliesOp>(a, b);
+}
+BitVector bitwise_equiv(const BitVector &a, const BitVector &b) {
+  return bulk<EquivOp>(a, b);
+}
+
+} // namespace libmltl
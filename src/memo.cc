@@ -0,0 +1,34 @@
+#include "memo.hh"
+
+using namespace std;
+namespace libmltl {
+
+MemoTrace::MemoTrace(const ASTNode &formula, const Trace &trace, size_t end)
+    : trace(trace), end(end) {
+  add_node(formula);
+  cache.assign(index.size() * end, 0);
+}
+
+void MemoTrace::add_node(const ASTNode &node) {
+  // constants and variables are as cheap to evaluate as to look up
+  if (node.get_type() == ASTNode::Type::Constant ||
+      node.get_type() == ASTNode::Type::Variable ||
+      !index.emplace(&node, index.size()).second) {
+    return;
+  }
+  if (node.is_unary_op()) {
+    add_node(static_cast<const UnaryOp &>(node).get_operand());
+  } else if (node.is_binary_op()) {
+    add_node(static_cast<const BinaryOp &>(node).get_left());
+    add_node(static_cast<const BinaryOp &>(node).get_right());
+  }
+}
+
+bool ASTNode::evaluate_memoized(const Trace &trace) const {
+  return evaluate_subt(MemoTrace(*this, trace, trace.size()), 0, trace.size());
+}
+bool ASTNode::evaluate_memoized(const vector<string> &trace) const {
+  return evaluate_memoized(Trace(trace));
+}
+
+} // namespace libmltl
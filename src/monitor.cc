@@ -0,0 +1,243 @@
+#include "monitor.hh"
+#include "satisfaction.hh"
+
+#include <algorithm>
+
+using namespace std;
+namespace libmltl {
+
+/* A temporal operator looks for the first position in its window where the
+ * right operand decides the verdict: where it holds for F and U, where it
+ * does not hold for G and R. The verdict then depends on whether the left
+ * operand decided it first, at a position where it does not hold for U or
+ * holds for R. right_events and left_events queue these positions as the
+ * operands produce their verdicts; positions before the start of the window
+ * are dropped when the verdict is computed, so each one is handled twice at
+ * most.
+ */
+
+bool is_temporal(ASTNode::Type type) {
+  return type == ASTNode::Type::Finally || type == ASTNode::Type::Globally ||
+         type == ASTNode::Type::Until || type == ASTNode::Type::Release;
+}
+
+/* Smallest power of two >= n.
+ */
+size_t ring_size(size_t n) {
+  size_t size = 1;
+  while (size < n) {
+    size <<= 1;
+  }
+  return size;
+}
+
+Monitor::Monitor(const ASTNode &formula)
+    : formula(formula.deep_copy()), num_vars(0), len(0) {
+  nodes.reserve(formula.size());
+  compile(*this->formula);
+  // operands keep their verdicts for as long as their parents read them, and
+  // temporal operators read the newest verdicts of their operands only
+  vector<size_t> history_size(nodes.size(), 1);
+  for (const Node &node : nodes) {
+    if (is_temporal(node.type)) {
+      continue;
+    }
+    for (size_t operand : {node.left, node.right}) {
+      if (operand != npos) {
+        history_size[operand] = max(history_size[operand],
+                                    node.delay - nodes[operand].delay + 1);
+      }
+    }
+  }
+  // a queue holds the time steps from the start of the previous window up to
+  // the newest verdict of its operand
+  size_t size = 0;
+  for (size_t i = 0; i < nodes.size(); ++i) {
+    Node &node = nodes[i];
+    node.history = size;
+    node.history_mask = ring_size(history_size[i]) - 1;
+    size += node.history_mask + 1;
+    if (!is_temporal(node.type)) {
+      continue;
+    }
+    for (auto [queue, operand] : {make_pair(&node.left_events, node.left),
+                                  make_pair(&node.right_events, node.right)}) {
+      size_t capacity = (operand == npos)
+                            ? 1
+                            : ring_size(node.delay - nodes[operand].delay + 2);
+      *queue = {size, capacity - 1, 0, 0};
+      size += capacity;
+    }
+  }
+  buffer.resize(size);
+  states.resize(delay() ? ring_size(delay()) : 0);
+}
+
+size_t Monitor::compile(const ASTNode &formula) {
+  Node node = {formula.get_type(), npos, npos, 0, 0, 0, 0, 0, {}, {}, npos};
+  if (formula.is_propositional_op() && is_tabulable(formula)) {
+    // a whole propositional subtree becomes one node without operands
+    node.table = tables.size();
+    tables.emplace_back(formula);
+    nodes.push_back(std::move(node));
+    return nodes.size() - 1;
+  }
+  switch (formula.get_type()) {
+  case ASTNode::Type::Constant:
+    node.lb = static_cast<const Constant &>(formula).get_value();
+    break;
+  case ASTNode::Type::Variable:
+    node.lb = static_cast<const Variable &>(formula).get_id();
+    break;
+  case ASTNode::Type::Negation:
+    node.left = compile(static_cast<const UnaryOp &>(formula).get_operand());
+    node.delay = nodes[node.left].delay;
+    break;
+  case ASTNode::Type::Finally:
+  case ASTNode::Type::Globally: {
+    const UnaryTempOp &op = static_cast<const UnaryTempOp &>(formula);
+    node.right = compile(op.get_operand());
+    node.lb = op.get_lower_bound();
+    node.ub = op.get_upper_bound();
+    node.delay = max(node.lb, node.ub + nodes[node.right].delay);
+    break;
+  }
+  case ASTNode::Type::Until:
+  case ASTNode::Type::Release: {
+    // left is only needed strictly before the end of the window
+    const BinaryTempOp &op = static_cast<const BinaryTempOp &>(formula);
+    node.left = compile(op.get_left());
+    node.right = compile(op.get_right());
+    node.lb = op.get_lower_bound();
+    node.ub = op.get_upper_bound();
+    size_t left_delay = nodes[node.left].delay;
+    node.delay = max(node.lb, node.ub + max(nodes[node.right].delay,
+                                            left_delay - (left_delay > 0)));
+    break;
+  }
+  default: {
+    const BinaryOp &op = static_cast<const BinaryOp &>(formula);
+    node.left = compile(op.get_left());
+    node.right = compile(op.get_right());
+    node.delay = max(nodes[node.left].delay, nodes[node.right].delay);
+    break;
+  }
+  }
+  nodes.push_back(std::move(node));
+  return nodes.size() - 1;
+}
+
+optional<bool> Monitor::push(const string &state) {
+  if (len == 0) {
+    num_vars = state.size();
+  }
+  size_t m = len++;
+  if (!states.empty()) {
+    string &stored = states[m & (states.size() - 1)];
+    stored.assign(state, 0, num_vars);
+    stored.resize(num_vars, '0');
+  }
+
+  for (Node &node : nodes) {
+    bool until = node.type == ASTNode::Type::Finally ||
+                 node.type == ASTNode::Type::Until;
+    bool release = node.type == ASTNode::Type::Globally ||
+                   node.type == ASTNode::Type::Release;
+    if (until || release) {
+      // the operands have produced their verdicts for this state already
+      if (m >= nodes[node.right].delay) {
+        size_t k = m - nodes[node.right].delay;
+        if (value(nodes[node.right], k) == until) {
+          push_event(node.right_events, k);
+        }
+      }
+      if (node.left != npos && m >= nodes[node.left].delay) {
+        size_t k = m - nodes[node.left].delay;
+        if (value(nodes[node.left], k) == release) {
+          push_event(node.left_events, k);
+        }
+      }
+    }
+    if (m < node.delay) {
+      continue;
+    }
+    size_t t = m - node.delay;
+    bool result;
+    if (node.table != npos) {
+      buffer[node.history + (t & node.history_mask)] =
+          tables[node.table].evaluate(state, num_vars);
+      continue;
+    }
+    switch (node.type) {
+    case ASTNode::Type::Constant:
+      result = node.lb;
+      break;
+    case ASTNode::Type::Variable:
+      result = node.lb < num_vars && node.lb < state.size() &&
+               state[node.lb] == '1';
+      break;
+    case ASTNode::Type::Negation:
+      result = !value(nodes[node.left], t);
+      break;
+    case ASTNode::Type::And:
+      result = value(nodes[node.left], t) && value(nodes[node.right], t);
+      break;
+    case ASTNode::Type::Xor:
+      result = value(nodes[node.left], t) != value(nodes[node.right], t);
+      break;
+    case ASTNode::Type::Or:
+      result = value(nodes[node.left], t) || value(nodes[node.right], t);
+      break;
+    case ASTNode::Type::Implies:
+      result = !value(nodes[node.left], t) || value(nodes[node.right], t);
+      break;
+    case ASTNode::Type::Equiv:
+      result = value(nodes[node.left], t) == value(nodes[node.right], t);
+      break;
+    default: {
+      size_t begin = t + node.lb;
+      size_t right = first_event(node.right_events, begin);
+      size_t left = first_event(node.left_events, begin);
+      bool decided_by_right =
+          right <= t + node.ub && (left == npos || left >= right);
+      result = until ? decided_by_right : !decided_by_right;
+      if (node.type == ASTNode::Type::Release && node.ub < node.lb) {
+        // see window_release in kernels.cc
+        result = (node.ub + 1 == node.lb);
+      }
+      break;
+    }
+    }
+    buffer[node.history + (t & node.history_mask)] = result;
+  }
+
+  const Node &root = nodes.back();
+  if (m < root.delay) {
+    return nullopt;
+  }
+  return value(root, m - root.delay);
+}
+
+BitVector Monitor::truncated_verdicts() const {
+  size_t begin = num_verdicts();
+  vector<string> suffix;
+  for (size_t t = begin; t < len; ++t) {
+    suffix.push_back(states[t & (states.size() - 1)]);
+  }
+  if (suffix.empty()) {
+    return BitVector();
+  }
+  // the verdicts at these time steps only depend on the states after them
+  return evaluate_all(*formula, Trace(suffix));
+}
+
+void Monitor::reset() {
+  num_vars = 0;
+  len = 0;
+  for (Node &node : nodes) {
+    node.left_events.head = node.left_events.count = 0;
+    node.right_events.head = node.right_events.count = 0;
+  }
+}
+
+} // namespace libmltl
@@ -1,4 +1,5 @@
 #include "parser.hh"
+#include "intervals.hh"
 
 #include <algorithm>
 #include <filesystem>
@@ -188,27 +189,47 @@ size_t find_lowest_prec_binary_op(const string &f, size_t pos, size_t len,
   return lowest_prec_pos;
 }
 
+/* Where the parser makes its nodes: through factory or in arena if either is
+ * set, on the heap otherwise.
+ */
+struct Builder {
+  ASTArena *arena;
+  FormulaFactory *factory;
+};
+
+template <typename T, typename... Args>
+shared_ptr<ASTNode> make_node(const Builder &builder, Args &&...args) {
+  if (builder.factory) {
+    return builder.factory->make<T>(std::forward<Args>(args)...);
+  }
+  return make_node<T>(builder.arena, std::forward<Args>(args)...);
+}
+
 // forward declare
-unique_ptr<ASTNode> parse_single_stmt(const string &f, size_t pos, size_t len,
-                                      const vector<size_t> &paren_map);
-unique_ptr<ASTNode> parse_compound_stmt(const string &f, size_t pos, size_t len,
-                                        const vector<size_t> &paren_map);
+shared_ptr<ASTNode> parse_single_stmt(const string &f, size_t pos, size_t len,
+                                      const vector<size_t> &paren_map,
+                                      const Builder &builder);
+shared_ptr<ASTNode> parse_compound_stmt(const string &f, size_t pos,
+                                        size_t len,
+                                        const vector<size_t> &paren_map,
+                                        const Builder &builder);
 
 /* Parses MLTL formula f, starts at character position pos and spans len
  * characters.
  */
-unique_ptr<ASTNode> parse(const string &f, size_t pos, size_t len,
-                          const vector<size_t> &paren_map) {
-  unique_ptr<ASTNode> ast;
+shared_ptr<ASTNode> parse(const string &f, size_t pos, size_t len,
+                          const vector<size_t> &paren_map,
+                          const Builder &builder) {
+  shared_ptr<ASTNode> ast;
 
   // try to parse as a single statement first, if that fails (returns
   // nullptr), then try to parse as a compound statement, if the fails then
   // abort.
-  ast = parse_single_stmt(f, pos, len, paren_map);
+  ast = parse_single_stmt(f, pos, len, paren_map, builder);
   if (ast != nullptr) {
     return ast;
   }
-  ast = parse_compound_stmt(f, pos, len, paren_map);
+  ast = parse_compound_stmt(f, pos, len, paren_map, builder);
   if (ast != nullptr) {
     return ast;
   }
@@ -217,9 +238,9 @@ unique_ptr<ASTNode> parse(const string &f, size_t pos, size_t len,
   return nullptr;
 }
 
-/* Fast recursive decent parser for MLTL.
+/* Fast recursive decent parser for MLTL, making the nodes with builder.
  */
-shared_ptr<ASTNode> parse(const string &formula) {
+shared_ptr<ASTNode> parse(const string &formula, const Builder &builder) {
   string f = formula;
   // trim whitespace
   f.erase(
@@ -253,14 +274,27 @@ shared_ptr<ASTNode> parse(const string &formula) {
           f.length()); // no return
   }
 
-  return parse(f, 0, f.length(), paren_map);
+  return parse(f, 0, f.length(), paren_map, builder);
+}
+
+shared_ptr<ASTNode> parse(const string &formula) {
+  return parse(formula, Builder{nullptr, nullptr});
+}
+
+shared_ptr<ASTNode> parse(const string &formula, ASTArena &arena) {
+  return parse(formula, Builder{&arena, nullptr});
+}
+
+shared_ptr<ASTNode> parse(const string &formula, FormulaFactory &factory) {
+  return parse(formula, Builder{nullptr, &factory});
 }
 
 /* Parses a single statement, returns nullptr is statement is a compound
  * statement.
  */
-unique_ptr<ASTNode> parse_single_stmt(const string &f, size_t pos, size_t len,
-                                      const vector<size_t> &paren_map) {
+shared_ptr<ASTNode> parse_single_stmt(const string &f, size_t pos, size_t len,
+                                      const vector<size_t> &paren_map,
+                                      const Builder &builder) {
 #if DEBUG
   cout << "[debug]: parse_single_stmt\n";
   cout << "[debug]:   f: " << f.substr(pos, len) << "\n";
@@ -271,26 +305,26 @@ unique_ptr<ASTNode> parse_single_stmt(const string &f, size_t pos, size_t len,
   size_t end = pos + len;
   size_t lb, ub, captured_length, end_subscript;
   unsigned int id;
-  unique_ptr<ASTNode> operand;
+  shared_ptr<ASTNode> operand;
   switch (f[pos]) {
   case 't':
     if (len == 1 || (len == 2 && f[pos + 1] == 't') ||
         (len == 4 && f[pos + 1] == 'r' && f[pos + 2] == 'u' &&
          f[pos + 3] == 'e')) { // t, tt, true
-      return make_unique<Constant>(true);
+      return make_node<Constant>(builder, true);
     }
     break;
   case 'f':
     if (len == 1 || (len == 2 && f[pos + 1] == 'f') ||
         (len == 5 && f[pos + 1] == 'a' && f[pos + 2] == 'l' &&
          f[pos + 3] == 's' && f[pos + 4] == 'e')) { // f, ff, false
-      return make_unique<Constant>(false);
+      return make_node<Constant>(builder, false);
     }
     break;
   case 'p':
     if (is_valid_num(f, pos + 1, len - 1)) {
       id = stoul(f.substr(pos + 1, len - 1));
-      return make_unique<Variable>(id);
+      return make_node<Variable>(builder, id);
     }
     break;
   case '(':
@@ -300,30 +334,30 @@ unique_ptr<ASTNode> parse_single_stmt(const string &f, size_t pos, size_t len,
 #endif
     if (captured_length + 2 == len) {
       // the whole string is encased in a set of parens, strip parse inside.
-      return parse(f, pos + 1, captured_length, paren_map);
+      return parse(f, pos + 1, captured_length, paren_map, builder);
     }
     break;
   case '~':
   case '!':
-    operand = parse_single_stmt(f, pos + 1, len - 1, paren_map);
+    operand = parse_single_stmt(f, pos + 1, len - 1, paren_map, builder);
     if (operand) {
-      return make_unique<Negation>(std::move(operand));
+      return make_node<Negation>(builder, std::move(operand));
     }
     break;
   case 'F':
     tie(lb, ub) = find_bounds(f, pos + 1, len - 1, &end_subscript);
-    operand =
-        parse_single_stmt(f, end_subscript, end - end_subscript, paren_map);
+    operand = parse_single_stmt(f, end_subscript, end - end_subscript,
+                                paren_map, builder);
     if (operand) {
-      return make_unique<Finally>(std::move(operand), lb, ub);
+      return make_node<Finally>(builder, std::move(operand), lb, ub);
     }
     break;
   case 'G':
     tie(lb, ub) = find_bounds(f, pos + 1, len - 1, &end_subscript);
-    operand =
-        parse_single_stmt(f, end_subscript, end - end_subscript, paren_map);
+    operand = parse_single_stmt(f, end_subscript, end - end_subscript,
+                                paren_map, builder);
     if (operand) {
-      return make_unique<Globally>(std::move(operand), lb, ub);
+      return make_node<Globally>(builder, std::move(operand), lb, ub);
     }
     break;
   default:
@@ -333,8 +367,10 @@ unique_ptr<ASTNode> parse_single_stmt(const string &f, size_t pos, size_t len,
   return nullptr;
 }
 
-unique_ptr<ASTNode> parse_compound_stmt(const string &f, size_t pos, size_t len,
-                                        const vector<size_t> &paren_map) {
+shared_ptr<ASTNode> parse_compound_stmt(const string &f, size_t pos,
+                                        size_t len,
+                                        const vector<size_t> &paren_map,
+                                        const Builder &builder) {
 #if DEBUG
   cout << "[debug]: parse_compound_stmt\n";
   cout << "[debug]:   f: " << f.substr(pos, len) << "\n";
@@ -344,37 +380,38 @@ unique_ptr<ASTNode> parse_compound_stmt(const string &f, size_t pos, size_t len,
 
   size_t end = pos + len;
   size_t lb, ub, end_subscript;
-  unique_ptr<ASTNode> left, right;
+  shared_ptr<ASTNode> left, right;
   size_t op_pos = find_lowest_prec_binary_op(f, pos, len, paren_map);
   switch (f[op_pos]) {
   case 'U':
     tie(lb, ub) = find_bounds(f, op_pos + 1, len - 1, &end_subscript);
-    left = parse(f, pos, op_pos - pos, paren_map);
-    right = parse(f, end_subscript, end - end_subscript, paren_map);
-    return make_unique<Until>(std::move(left), std::move(right), lb, ub);
+    left = parse(f, pos, op_pos - pos, paren_map, builder);
+    right = parse(f, end_subscript, end - end_subscript, paren_map, builder);
+    return make_node<Until>(builder, std::move(left), std::move(right), lb, ub);
   case 'R':
     tie(lb, ub) = find_bounds(f, op_pos + 1, len - 1, &end_subscript);
-    left = parse(f, pos, op_pos - pos, paren_map);
-    right = parse(f, end_subscript, end - end_subscript, paren_map);
-    return make_unique<Release>(std::move(left), std::move(right), lb, ub);
+    left = parse(f, pos, op_pos - pos, paren_map, builder);
+    right = parse(f, end_subscript, end - end_subscript, paren_map, builder);
+    return make_node<Release>(builder, std::move(left), std::move(right), lb,
+                              ub);
   case '&':
-    left = parse(f, pos, op_pos - pos, paren_map);
-    right = parse(f, op_pos + 1, end - op_pos - 1, paren_map);
-    return make_unique<And>(std::move(left), std::move(right));
+    left = parse(f, pos, op_pos - pos, paren_map, builder);
+    right = parse(f, op_pos + 1, end - op_pos - 1, paren_map, builder);
+    return make_node<And>(builder, std::move(left), std::move(right));
   case '^':
-    left = parse(f, pos, op_pos - pos, paren_map);
-    right = parse(f, op_pos + 1, end - op_pos - 1, paren_map);
-    return make_unique<Xor>(std::move(left), std::move(right));
+    left = parse(f, pos, op_pos - pos, paren_map, builder);
+    right = parse(f, op_pos + 1, end - op_pos - 1, paren_map, builder);
+    return make_node<Xor>(builder, std::move(left), std::move(right));
   case '|':
-    left = parse(f, pos, op_pos - pos, paren_map);
-    right = parse(f, op_pos + 1, end - op_pos - 1, paren_map);
-    return make_unique<Or>(std::move(left), std::move(right));
+    left = parse(f, pos, op_pos - pos, paren_map, builder);
+    right = parse(f, op_pos + 1, end - op_pos - 1, paren_map, builder);
+    return make_node<Or>(builder, std::move(left), std::move(right));
   case '-':
     if (pos < op_pos && op_pos + 1 < end && f[op_pos - 1] != '<' &&
         f[op_pos + 1] == '>') {
-      left = parse(f, pos, op_pos - pos, paren_map);
-      right = parse(f, op_pos + 2, end - op_pos - 2, paren_map);
-      return make_unique<Implies>(std::move(left), std::move(right));
+      left = parse(f, pos, op_pos - pos, paren_map, builder);
+      right = parse(f, op_pos + 2, end - op_pos - 2, paren_map, builder);
+      return make_node<Implies>(builder, std::move(left), std::move(right));
     }
     break;
   case '<':
@@ -383,17 +420,17 @@ unique_ptr<ASTNode> parse_compound_stmt(const string &f, size_t pos, size_t len,
     }
     [[fallthrough]];
   case '=':
-    left = parse(f, pos, op_pos - pos, paren_map);
-    right = parse(f, op_pos + 3, end - op_pos - 3, paren_map);
-    return make_unique<Equiv>(std::move(left), std::move(right));
+    left = parse(f, pos, op_pos - pos, paren_map, builder);
+    right = parse(f, op_pos + 3, end - op_pos - 3, paren_map, builder);
+    return make_node<Equiv>(builder, std::move(left), std::move(right));
   default:
     break; // not an operator, continue the search
   }
   return nullptr;
 }
 
-vector<string> read_trace_file(const string &trace_file_path) {
-  vector<string> trace;
+template <typename T> T read_trace_file(const string &trace_file_path) {
+  T trace;
   ifstream infile;
   string line;
   infile.open(trace_file_path);
@@ -413,15 +450,31 @@ vector<string> read_trace_file(const string &trace_file_path) {
   return trace;
 }
 
-vector<vector<string>> read_trace_files(const string &trace_directory_path) {
-  vector<vector<string>> traces;
+template <typename T>
+vector<T> read_trace_files(const string &trace_directory_path) {
+  vector<T> traces;
   for (const auto &entry : fs::directory_iterator(trace_directory_path)) {
-    vector<string> new_trace = read_trace_file(entry.path());
-    traces.emplace_back(new_trace);
+    traces.emplace_back(read_trace_file<T>(entry.path()));
   }
   return traces;
 }
 
+template vector<string>
+read_trace_file<vector<string>>(const string &trace_file_path);
+template Trace read_trace_file<Trace>(const string &trace_file_path);
+template IntervalTrace
+read_trace_file<IntervalTrace>(const string &trace_file_path);
+template DictionaryTrace
+read_trace_file<DictionaryTrace>(const string &trace_file_path);
+template vector<vector<string>>
+read_trace_files<vector<string>>(const string &trace_directory_path);
+template vector<Trace>
+read_trace_files<Trace>(const string &trace_directory_path);
+template vector<IntervalTrace>
+read_trace_files<IntervalTrace>(const string &trace_directory_path);
+template vector<DictionaryTrace>
+read_trace_files<DictionaryTrace>(const string &trace_directory_path);
+
 string int_to_bin_str(unsigned int n, int width) {
   string result;
   for (int i = 0; i < width; ++i) {
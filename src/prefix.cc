@@ -0,0 +1,228 @@
+#include "prefix.hh"
+#include "kernels.hh"
+#include "satisfaction.hh"
+
+#include <algorithm>
+
+using namespace std;
+namespace libmltl {
+
+BitVector conj(const BitVector &a, const BitVector &b) {
+  return bitwise_and(a, b);
+}
+BitVector disj(const BitVector &a, const BitVector &b) {
+  return bitwise_or(a, b);
+}
+bool conj(bool a, bool b) { return a && b; }
+bool disj(bool a, bool b) { return a || b; }
+
+/* Kleene's three-valued propositional operators on (is true, is false)
+ * pairs.
+ */
+template <typename V>
+void combine(ASTNode::Type type, const V &lt, const V &lf, const V &rt,
+             const V &rf, V &t, V &f) {
+  switch (type) {
+  case ASTNode::Type::And:
+    t = conj(lt, rt);
+    f = disj(lf, rf);
+    break;
+  case ASTNode::Type::Or:
+    t = disj(lt, rt);
+    f = conj(lf, rf);
+    break;
+  case ASTNode::Type::Implies:
+    t = disj(lf, rt);
+    f = conj(lt, rf);
+    break;
+  case ASTNode::Type::Xor:
+    t = disj(conj(lt, rf), conj(lf, rt));
+    f = disj(conj(lt, rt), conj(lf, rf));
+    break;
+  default: // ASTNode::Type::Equiv
+    t = disj(conj(lt, rt), conj(lf, rf));
+    f = disj(conj(lt, rf), conj(lf, rt));
+    break;
+  }
+}
+
+/* operand over the prefix followed by enough time steps with value beyond
+ * that the windows [i+lb, i+ub] of all time steps i of the prefix are
+ * complete.
+ */
+BitVector extend(const BitVector &operand, bool beyond, size_t lb,
+                 size_t ub) {
+  BitVector result = operand;
+  result.resize(operand.size() + max(lb, ub) + 1, beyond);
+  return result;
+}
+
+/* Time steps in a window may lie past the prefix, where the operand takes
+ * its beyond value if the continuation has them, or the trace may end before
+ * the window starts. A verdict that needs the window to be present (F holds,
+ * G fails, U holds or R fails somewhere in it) is therefore decided from the
+ * prefix alone, with the usual truncated semantics at its end, while its
+ * negation must hold for the complete window of the longest continuation.
+ */
+PrefixSatisfaction evaluate_prefix_all(const ASTNode &formula,
+                                       const Trace &prefix, size_t n) {
+  PrefixSatisfaction result;
+  switch (formula.get_type()) {
+  case ASTNode::Type::Constant: {
+    bool value = static_cast<const Constant &>(formula).get_value();
+    result.is_true = BitVector(n, value);
+    result.is_false = BitVector(n, !value);
+    result.beyond_true = value;
+    result.beyond_false = !value;
+    return result;
+  }
+  case ASTNode::Type::Variable: {
+    unsigned int id = static_cast<const Variable &>(formula).get_id();
+    if (id < prefix.num_vars()) {
+      result.is_true = prefix.get_variable(id);
+      result.is_true.resize(n);
+    } else {
+      result.is_true = BitVector(n);
+    }
+    result.is_false = bitwise_not(result.is_true);
+    // continuations have the same variables as the prefix
+    result.beyond_true = false;
+    result.beyond_false = prefix.num_vars() > 0 && id >= prefix.num_vars();
+    return result;
+  }
+  case ASTNode::Type::Negation: {
+    result = evaluate_prefix_all(
+        static_cast<const UnaryOp &>(formula).get_operand(), prefix, n);
+    swap(result.is_true, result.is_false);
+    swap(result.beyond_true, result.beyond_false);
+    return result;
+  }
+  case ASTNode::Type::Finally:
+  case ASTNode::Type::Globally: {
+    const UnaryTempOp &op = static_cast<const UnaryTempOp &>(formula);
+    size_t lb = op.get_lower_bound(), ub = op.get_upper_bound();
+    PrefixSatisfaction operand =
+        evaluate_prefix_all(op.get_operand(), prefix, n);
+    if (formula.get_type() == ASTNode::Type::Finally) {
+      result.is_true = window_any(operand.is_true, lb, ub);
+      result.is_false = bitwise_not(window_any(
+          extend(bitwise_not(operand.is_false), !operand.beyond_false, lb,
+                 ub),
+          lb, ub));
+      result.beyond_true = lb == 0 && lb <= ub && operand.beyond_true;
+      result.beyond_false = operand.beyond_false || ub < lb;
+    } else {
+      result.is_true =
+          window_all(extend(operand.is_true, operand.beyond_true, lb, ub),
+                     lb, ub);
+      result.is_false = window_any(operand.is_false, lb, ub);
+      result.beyond_true = operand.beyond_true || ub < lb;
+      result.beyond_false = lb == 0 && lb <= ub && operand.beyond_false;
+    }
+    break;
+  }
+  case ASTNode::Type::Until:
+  case ASTNode::Type::Release: {
+    const BinaryTempOp &op = static_cast<const BinaryTempOp &>(formula);
+    size_t lb = op.get_lower_bound(), ub = op.get_upper_bound();
+    PrefixSatisfaction left = evaluate_prefix_all(op.get_left(), prefix, n);
+    PrefixSatisfaction right = evaluate_prefix_all(op.get_right(), prefix, n);
+    if (formula.get_type() == ASTNode::Type::Until) {
+      result.is_true = window_until(left.is_true, right.is_true, lb, ub);
+      result.is_false = bitwise_not(window_until(
+          extend(bitwise_not(left.is_false), !left.beyond_false, lb, ub),
+          extend(bitwise_not(right.is_false), !right.beyond_false, lb, ub),
+          lb, ub));
+      result.beyond_true = lb == 0 && lb <= ub && right.beyond_true;
+      result.beyond_false = right.beyond_false || ub < lb;
+    } else {
+      result.is_true = window_release(
+          extend(left.is_true, left.beyond_true, lb, ub),
+          extend(right.is_true, right.beyond_true, lb, ub), lb, ub);
+      if (ub < lb) {
+        // see window_release in kernels.cc, false unless truncated, which
+        // no continuation is for i + lb < n
+        result.is_false = BitVector(n - min(n, lb), ub + 1 != lb);
+        result.is_false.resize(n);
+        result.beyond_true = (ub + 1 == lb);
+        result.beyond_false = false;
+      } else {
+        result.is_false = window_until(left.is_false, right.is_false, lb, ub);
+        result.beyond_true = right.beyond_true;
+        result.beyond_false = lb == 0 && right.beyond_false;
+      }
+    }
+    break;
+  }
+  default: {
+    const BinaryOp &op = static_cast<const BinaryOp &>(formula);
+    PrefixSatisfaction left = evaluate_prefix_all(op.get_left(), prefix, n);
+    PrefixSatisfaction right = evaluate_prefix_all(op.get_right(), prefix, n);
+    combine(formula.get_type(), left.is_true, left.is_false, right.is_true,
+            right.is_false, result.is_true, result.is_false);
+    combine(formula.get_type(), left.beyond_true, left.beyond_false,
+            right.beyond_true, right.beyond_false, result.beyond_true,
+            result.beyond_false);
+    return result;
+  }
+  }
+  // the extended operands give results past the prefix
+  result.is_true.resize(n);
+  result.is_false.resize(n);
+  return result;
+}
+
+PrefixSatisfaction evaluate_prefix_all(const ASTNode &formula,
+                                       const Trace &prefix) {
+  return evaluate_prefix_all(formula, prefix, prefix.size());
+}
+
+/* Verdict of formula on the first n states of trace.
+ */
+Verdict evaluate_prefix(const ASTNode &formula, const Trace &trace,
+                        size_t n) {
+  PrefixSatisfaction satisfaction = evaluate_prefix_all(formula, trace, n);
+  if (n > 0) {
+    return satisfaction.get(0);
+  }
+  // time step 0 is past the empty prefix, or the trace stays empty
+  bool empty = formula.evaluate(Trace());
+  if (satisfaction.beyond_true && empty) {
+    return Verdict::True;
+  }
+  if (satisfaction.beyond_false && !empty) {
+    return Verdict::False;
+  }
+  return Verdict::Unknown;
+}
+
+Verdict evaluate_prefix(const ASTNode &formula, const Trace &prefix) {
+  return evaluate_prefix(formula, prefix, prefix.size());
+}
+Verdict evaluate_prefix(const ASTNode &formula, const vector<string> &prefix) {
+  return evaluate_prefix(formula, Trace(prefix));
+}
+
+size_t decision_length(const ASTNode &formula, const Trace &trace) {
+  // a decided verdict stays decided when the prefix grows, and every
+  // verdict is decided once evaluation_reach states are known
+  size_t high = min(trace.size(), evaluation_reach(formula));
+  if (evaluate_prefix(formula, trace, high) == Verdict::Unknown) {
+    return (size_t)-1;
+  }
+  size_t low = 0;
+  while (low < high) {
+    size_t mid = low + (high - low) / 2;
+    if (evaluate_prefix(formula, trace, mid) == Verdict::Unknown) {
+      low = mid + 1;
+    } else {
+      high = mid;
+    }
+  }
+  return low;
+}
+size_t decision_length(const ASTNode &formula, const vector<string> &trace) {
+  return decision_length(formula, Trace(trace));
+}
+
+} // namespace libmltl
@@ -1,14 +1,81 @@
+#include <fstream>
+
 #include <pybind11/operators.h>
 #include <pybind11/pybind11.h>
 #include <pybind11/stl.h>
 
+#include "batch.hh"
+#include "compiled.hh"
+#include "flat.hh"
+#include "intervals.hh"
+#include "jit.hh"
+#include "monitor.hh"
 #include "parser.hh"
+#include "prefix.hh"
+#include "satisfaction.hh"
+#include "stream.hh"
+#include "truth_table.hh"
 
 namespace py = pybind11;
 using namespace std;
 using namespace libmltl;
 
 PYBIND11_MODULE(libmltl, m) {
+  /* trace.hh
+   */
+  py::class_<BitVector>(m, "BitVector")
+      .def(py::init<>())
+      .def(py::init<size_t, bool>(), py::arg("length"),
+           py::arg("value") = false)
+      .def("size", &BitVector::size)
+      .def("get", &BitVector::get)
+      .def("set", &BitVector::set)
+      .def("push_back", &BitVector::push_back)
+      .def("count", &BitVector::count)
+      .def("find_next", &BitVector::find_next)
+      .def("find_next_unset", &BitVector::find_next_unset)
+      .def("as_string", &BitVector::as_string)
+      .def("slice", &BitVector::slice)
+      .def("__len__", &BitVector::size)
+      .def("__getitem__", &BitVector::get)
+      .def(py::self == py::self)
+      .def(py::self != py::self);
+
+  py::class_<Trace>(m, "Trace")
+      .def(py::init<>())
+      .def(py::init<size_t, size_t>())
+      .def(py::init<const vector<string> &>())
+      .def("size", &Trace::size)
+      .def("num_vars", &Trace::num_vars)
+      .def("get", &Trace::get)
+      .def("set", &Trace::set)
+      .def("get_variable",
+           py::overload_cast<unsigned int>(&Trace::get_variable, py::const_),
+           py::return_value_policy::reference_internal)
+      .def("push_back", &Trace::push_back)
+      .def("get_state", &Trace::get_state)
+      .def("as_strings", &Trace::as_strings)
+      .def("slice", &Trace::slice)
+      .def("__len__", &Trace::size);
+
+  py::class_<DictionaryTrace>(m, "DictionaryTrace")
+      .def(py::init<>())
+      .def(py::init<const vector<string> &>())
+      .def(py::init<const Trace &>())
+      .def("size", &DictionaryTrace::size)
+      .def("num_vars", &DictionaryTrace::num_vars)
+      .def("num_states", &DictionaryTrace::num_states)
+      .def("id_width", &DictionaryTrace::id_width)
+      .def("get_id", &DictionaryTrace::get_id)
+      .def("get_states", &DictionaryTrace::get_states,
+           py::return_value_policy::reference_internal)
+      .def("get", &DictionaryTrace::get)
+      .def("push_back", &DictionaryTrace::push_back)
+      .def("get_state", &DictionaryTrace::get_state)
+      .def("as_strings", &DictionaryTrace::as_strings)
+      .def("to_trace", &DictionaryTrace::to_trace)
+      .def("__len__", &DictionaryTrace::size);
+
   /* ast.hh
    */
   py::class_<ASTNode, shared_ptr<ASTNode>>(m, "ASTNode")
@@ -20,13 +87,37 @@ PYBIND11_MODULE(libmltl, m) {
       .def("as_string", &ASTNode::as_string)
       .def("as_pretty_string", &ASTNode::as_pretty_string)
       .def("get_symbol", &ASTNode::get_symbol)
-      .def("evaluate", &ASTNode::evaluate)
-      .def("evaluate_subt", &ASTNode::evaluate_subt)
+      .def("evaluate",
+           py::overload_cast<const vector<string> &>(&ASTNode::evaluate,
+                                                     py::const_))
+      .def("evaluate",
+           py::overload_cast<const Trace &>(&ASTNode::evaluate, py::const_))
+      .def("evaluate_subt",
+           py::overload_cast<const vector<string> &, size_t, size_t>(
+               &ASTNode::evaluate_subt, py::const_))
+      .def("evaluate_subt",
+           py::overload_cast<const Trace &, size_t, size_t>(
+               &ASTNode::evaluate_subt, py::const_))
+      .def("evaluate_all",
+           py::overload_cast<const vector<string> &>(&ASTNode::evaluate_all,
+                                                     py::const_))
+      .def("evaluate_all", py::overload_cast<const Trace &>(
+                               &ASTNode::evaluate_all, py::const_))
+      .def("evaluate_memoized",
+           py::overload_cast<const vector<string> &>(
+               &ASTNode::evaluate_memoized, py::const_))
+      .def("evaluate_memoized", py::overload_cast<const Trace &>(
+                                    &ASTNode::evaluate_memoized, py::const_))
       .def("future_reach", &ASTNode::future_reach)
       .def("size", &ASTNode::size)
       .def("depth", &ASTNode::depth)
       .def("count", &ASTNode::count)
-      .def("deep_copy", &ASTNode::deep_copy)
+      .def("hash", &ASTNode::hash)
+      .def("__hash__", &ASTNode::hash)
+      .def("rehash", &ASTNode::rehash)
+      .def("deep_copy",
+           py::overload_cast<>(&ASTNode::deep_copy, py::const_))
+      .def("compare", &ASTNode::compare)
       .def(py::self == py::self)
       .def(py::self != py::self)
       .def(py::self < py::self)
@@ -131,8 +222,226 @@ PYBIND11_MODULE(libmltl, m) {
 
   /* parser.hh
    */
-  m.def("parse", &parse);
-  m.def("read_trace_file", &read_trace_file);
-  m.def("read_trace_files", &read_trace_files);
+  m.def("parse", py::overload_cast<const string &>(&parse));
+  m.def("parse",
+        py::overload_cast<const string &, FormulaFactory &>(&parse));
+  m.def("read_trace_file", &read_trace_file<vector<string>>);
+  m.def("read_trace_files", &read_trace_files<vector<string>>);
+  m.def("read_packed_trace_file", &read_trace_file<Trace>);
+  m.def("read_dictionary_trace_file", &read_trace_file<DictionaryTrace>);
+  m.def("read_packed_trace_files", &read_trace_files<Trace>);
   m.def("int_to_bin_str", &int_to_bin_str);
+
+  /* factory.hh
+   */
+  py::class_<FormulaFactory>(m, "FormulaFactory")
+      .def(py::init<>())
+      .def("intern", &FormulaFactory::intern)
+      .def("size", &FormulaFactory::size)
+      .def("clear", &FormulaFactory::clear);
+
+  /* arena.hh
+   */
+  py::class_<UniqueFormula>(m, "UniqueFormula")
+      .def(py::init<const ASTNode &>())
+      .def(py::init<const string &>())
+      .def("empty", &UniqueFormula::empty)
+      .def("get", &UniqueFormula::get,
+           py::return_value_policy::reference_internal);
+
+  /* flat.hh
+   */
+  py::class_<FlatFormula>(m, "FlatFormula")
+      .def(py::init<>())
+      .def(py::init<const ASTNode &>())
+      .def("to_ast", py::overload_cast<>(&FlatFormula::to_ast, py::const_))
+      .def("get_types", &FlatFormula::get_types)
+      .def("get_lower_bounds", &FlatFormula::get_lower_bounds)
+      .def("get_upper_bounds", &FlatFormula::get_upper_bounds)
+      .def("get_lefts", &FlatFormula::get_lefts)
+      .def("get_rights", &FlatFormula::get_rights)
+      .def("get_values", &FlatFormula::get_values)
+      .def("future_reach", &FlatFormula::future_reach)
+      .def("size", &FlatFormula::size)
+      .def("depth", &FlatFormula::depth)
+      .def("count", &FlatFormula::count)
+      .def(py::self == py::self)
+      .def(py::self != py::self);
+
+  /* satisfaction.hh
+   */
+  m.def("evaluation_reach", &evaluation_reach);
+  m.def("evaluate_all",
+        py::overload_cast<const ASTNode &, const DictionaryTrace &>(
+            &evaluate_all));
+  m.def("evaluate_all",
+        py::overload_cast<const ASTNode &, const Trace &, unsigned int,
+                          size_t>(&evaluate_all),
+        py::arg("formula"), py::arg("trace"), py::arg("num_threads") = 0,
+        py::arg("chunk_size") = 0, py::call_guard<py::gil_scoped_release>());
+  py::class_<EvaluationContext>(m, "EvaluationContext")
+      .def(py::init<const vector<shared_ptr<ASTNode>> &>())
+      .def("num_formulas", &EvaluationContext::num_formulas)
+      .def("num_nodes", &EvaluationContext::num_nodes)
+      .def("evaluate", py::overload_cast<const vector<string> &>(
+                           &EvaluationContext::evaluate, py::const_))
+      .def("evaluate", py::overload_cast<const Trace &>(
+                           &EvaluationContext::evaluate, py::const_));
+
+  /* compiled.hh
+   */
+  py::class_<CompiledFormula>(m, "CompiledFormula")
+      .def(py::init<>())
+      .def(py::init<const ASTNode &>())
+      .def("size", &CompiledFormula::size)
+      .def("evaluation_reach", &CompiledFormula::evaluation_reach)
+      .def("evaluate", py::overload_cast<const vector<string> &>(
+                           &CompiledFormula::evaluate, py::const_))
+      .def("evaluate", py::overload_cast<const Trace &>(
+                           &CompiledFormula::evaluate, py::const_));
+
+  /* jit.hh
+   */
+  py::class_<JitFormula>(m, "JitFormula")
+      .def(py::init<const ASTNode &>())
+      .def(py::init<const ASTNode &, const string &>())
+      .def("loaded_from_cache", &JitFormula::loaded_from_cache)
+      .def("evaluate", py::overload_cast<const vector<string> &>(
+                           &JitFormula::evaluate, py::const_))
+      .def("evaluate", py::overload_cast<const Trace &>(&JitFormula::evaluate,
+                                                        py::const_))
+      .def_static("jit_cache_dir", &JitFormula::jit_cache_dir)
+      .def_static("generate_source", &JitFormula::generate_source);
+
+  /* truth_table.hh
+   */
+  py::class_<TruthTable>(m, "TruthTable")
+      .def(py::init<const ASTNode &>())
+      .def("get_vars", &TruthTable::get_vars)
+      .def("num_vars", &TruthTable::num_vars)
+      .def("lookup", &TruthTable::lookup)
+      .def("evaluate", &TruthTable::evaluate);
+  m.def("is_tabulable", &is_tabulable);
+
+  /* monitor.hh
+   */
+  py::class_<Monitor>(m, "Monitor")
+      .def(py::init<const ASTNode &>())
+      .def("push", &Monitor::push)
+      .def("truncated_verdicts", &Monitor::truncated_verdicts)
+      .def("reset", &Monitor::reset)
+      .def("size", &Monitor::size)
+      .def("num_verdicts", &Monitor::num_verdicts)
+      .def("delay", &Monitor::delay)
+      .def("__len__", &Monitor::size);
+
+  /* prefix.hh
+   */
+  // False and True are Python keywords, so Verdict.False would not parse
+  py::enum_<Verdict>(m, "Verdict")
+      .value("False_", Verdict::False)
+      .value("True_", Verdict::True)
+      .value("Unknown", Verdict::Unknown);
+  py::class_<PrefixSatisfaction>(m, "PrefixSatisfaction")
+      .def_readonly("is_true", &PrefixSatisfaction::is_true)
+      .def_readonly("is_false", &PrefixSatisfaction::is_false)
+      .def_readonly("beyond_true", &PrefixSatisfaction::beyond_true)
+      .def_readonly("beyond_false", &PrefixSatisfaction::beyond_false)
+      .def("size", &PrefixSatisfaction::size)
+      .def("get", &PrefixSatisfaction::get)
+      .def("__len__", &PrefixSatisfaction::size)
+      .def("__getitem__", &PrefixSatisfaction::get);
+  m.def("evaluate_prefix_all",
+        py::overload_cast<const ASTNode &, const Trace &>(&evaluate_prefix_all));
+  m.def("evaluate_prefix", py::overload_cast<const ASTNode &, const Trace &>(
+                               &evaluate_prefix));
+  m.def("evaluate_prefix",
+        py::overload_cast<const ASTNode &, const vector<string> &>(
+            &evaluate_prefix));
+  m.def("decision_length", py::overload_cast<const ASTNode &, const Trace &>(
+                               &decision_length));
+  m.def("decision_length",
+        py::overload_cast<const ASTNode &, const vector<string> &>(
+            &decision_length));
+
+  /* intervals.hh
+   */
+  py::class_<IntervalSet>(m, "IntervalSet")
+      .def(py::init<>())
+      .def(py::init<const BitVector &>())
+      .def("num_intervals", &IntervalSet::num_intervals)
+      .def("begin", &IntervalSet::begin)
+      .def("end", &IntervalSet::end)
+      .def("empty", &IntervalSet::empty)
+      .def("push_back", &IntervalSet::push_back)
+      .def("contains", &IntervalSet::contains)
+      .def("count", &IntervalSet::count)
+      .def("to_bitvector", &IntervalSet::to_bitvector)
+      .def("__len__", &IntervalSet::num_intervals)
+      .def("__contains__", &IntervalSet::contains)
+      .def(py::self == py::self)
+      .def(py::self != py::self);
+  py::class_<IntervalTrace>(m, "IntervalTrace")
+      .def(py::init<>())
+      .def(py::init<size_t, const vector<IntervalSet> &>())
+      .def(py::init<const Trace &>())
+      .def(py::init<const vector<string> &>())
+      .def("size", &IntervalTrace::size)
+      .def("num_vars", &IntervalTrace::num_vars)
+      .def("get_variable", &IntervalTrace::get_variable,
+           py::return_value_policy::reference_internal)
+      .def("push_back", &IntervalTrace::push_back)
+      .def("to_trace", &IntervalTrace::to_trace)
+      .def("__len__", &IntervalTrace::size);
+  m.def("evaluate_intervals", &evaluate_intervals);
+  m.def("read_interval_trace_file", &read_trace_file<IntervalTrace>);
+
+  /* stream.hh
+   */
+  py::class_<StreamStats>(m, "StreamStats")
+      .def_readonly("steps", &StreamStats::steps)
+      .def_readonly("seconds", &StreamStats::seconds)
+      .def("steps_per_second", &StreamStats::steps_per_second);
+  m.def(
+      "evaluate_trace_file",
+      [](const ASTNode &formula, const string &trace_file_path,
+         const string &out_file_path, bool all_steps, size_t window_size) {
+        ofstream out(out_file_path, ios::binary);
+        if (!out.is_open()) {
+          throw runtime_error("cannot open output file " + out_file_path);
+        }
+        return evaluate_trace_file(formula, trace_file_path, out, all_steps,
+                                   window_size);
+      },
+      py::arg("formula"), py::arg("trace_file_path"),
+      py::arg("out_file_path"), py::arg("all_steps") = true,
+      py::arg("window_size") = default_stream_window,
+      py::call_guard<py::gil_scoped_release>());
+
+  /* batch.hh
+   */
+  py::class_<TraceBatch>(m, "TraceBatch")
+      .def(py::init<>())
+      .def(py::init<const vector<Trace> &>())
+      .def(py::init<const vector<Trace> &, size_t, size_t>())
+      .def(py::init<const vector<vector<string>> &>())
+      .def(py::init<const vector<vector<string>> &, size_t, size_t>())
+      .def("size", &TraceBatch::size)
+      .def("num_vars", &TraceBatch::num_vars)
+      .def("num_traces", &TraceBatch::num_traces)
+      .def("num_lanes", &TraceBatch::num_lanes)
+      .def("__len__", &TraceBatch::num_traces);
+  m.def("evaluate_batch", py::overload_cast<const ASTNode &, const TraceBatch &>(
+                              &evaluate_batch));
+  m.def("evaluate_batch",
+        py::overload_cast<const vector<shared_ptr<ASTNode>> &,
+                          const vector<Trace> &, unsigned int>(&evaluate_batch),
+        py::arg("formulas"), py::arg("traces"), py::arg("num_threads") = 0,
+        py::call_guard<py::gil_scoped_release>());
+  m.def("evaluate_batch",
+        py::overload_cast<const vector<shared_ptr<ASTNode>> &,
+                          const vector<vector<string>> &, unsigned int>(
+            &evaluate_batch),
+        py::arg("formulas"), py::arg("traces"), py::arg("num_threads") = 0,
+        py::call_guard<py::gil_scoped_release>());
 }
@@ -0,0 +1,352 @@
+#include "satisfaction.hh"
+#include "kernels.hh"
+
+#include <algorithm>
+#include <optional>
+
+using namespace std;
+namespace libmltl {
+
+/* Satisfaction vector of formula over trace from those of its operands: none
+ * for constants and variables, the operand as left for unary operators.
+ */
+BitVector apply_operator(const ASTNode &formula, const Trace &trace,
+                         const BitVector *left, const BitVector *right) {
+  switch (formula.get_type()) {
+  case ASTNode::Type::Constant:
+    return BitVector(trace.size(),
+                     static_cast<const Constant &>(formula).get_value());
+  case ASTNode::Type::Variable: {
+    unsigned int id = static_cast<const Variable &>(formula).get_id();
+    if (id >= trace.num_vars()) {
+      return BitVector(trace.size());
+    }
+    return trace.get_variable(id);
+  }
+  case ASTNode::Type::Negation:
+    return bitwise_not(*left);
+  case ASTNode::Type::Finally: {
+    const UnaryTempOp &op = static_cast<const UnaryTempOp &>(formula);
+    return window_any(*left, op.get_lower_bound(), op.get_upper_bound());
+  }
+  case ASTNode::Type::Globally: {
+    const UnaryTempOp &op = static_cast<const UnaryTempOp &>(formula);
+    return window_all(*left, op.get_lower_bound(), op.get_upper_bound());
+  }
+  case ASTNode::Type::And:
+    return bitwise_and(*left, *right);
+  case ASTNode::Type::Xor:
+    return bitwise_xor(*left, *right);
+  case ASTNode::Type::Or:
+    return bitwise_or(*left, *right);
+  case ASTNode::Type::Implies:
+    return bitwise_implies(*left, *right);
+  case ASTNode::Type::Equiv:
+    return bitwise_equiv(*left, *right);
+  case ASTNode::Type::Until: {
+    const BinaryTempOp &op = static_cast<const BinaryTempOp &>(formula);
+    return window_until(*left, *right, op.get_lower_bound(),
+                        op.get_upper_bound());
+  }
+  default: { // ASTNode::Type::Release
+    const BinaryTempOp &op = static_cast<const BinaryTempOp &>(formula);
+    return window_release(*left, *right, op.get_lower_bound(),
+                          op.get_upper_bound());
+  }
+  }
+}
+
+/* Evaluates F over G, G over F and U with a U as right operand with the fused
+ * kernels of kernels.hh, which never build the satisfaction vector of the
+ * inner operator. Returns nothing for other formulas.
+ */
+optional<BitVector> evaluate_fused(const ASTNode &formula, const Trace &trace) {
+  ASTNode::Type type = formula.get_type();
+  if (type == ASTNode::Type::Finally || type == ASTNode::Type::Globally) {
+    const UnaryTempOp &outer = static_cast<const UnaryTempOp &>(formula);
+    const ASTNode &operand = outer.get_operand();
+    ASTNode::Type inner_type = (type == ASTNode::Type::Finally)
+                                   ? ASTNode::Type::Globally
+                                   : ASTNode::Type::Finally;
+    if (operand.get_type() != inner_type) {
+      return nullopt;
+    }
+    const UnaryTempOp &inner = static_cast<const UnaryTempOp &>(operand);
+    BitVector inner_operand = evaluate_all(inner.get_operand(), trace);
+    size_t lb1 = outer.get_lower_bound(), ub1 = outer.get_upper_bound();
+    size_t lb2 = inner.get_lower_bound(), ub2 = inner.get_upper_bound();
+    return (type == ASTNode::Type::Finally)
+               ? window_any_all(inner_operand, lb1, ub1, lb2, ub2)
+               : window_all_any(inner_operand, lb1, ub1, lb2, ub2);
+  }
+  if (type == ASTNode::Type::Until &&
+      static_cast<const BinaryOp &>(formula).get_right().get_type() ==
+          ASTNode::Type::Until) {
+    const BinaryTempOp &outer = static_cast<const BinaryTempOp &>(formula);
+    const BinaryTempOp &inner =
+        static_cast<const BinaryTempOp &>(outer.get_right());
+    BitVector left = evaluate_all(outer.get_left(), trace);
+    BitVector mid = evaluate_all(inner.get_left(), trace);
+    BitVector right = evaluate_all(inner.get_right(), trace);
+    return window_until_until(left, mid, right, outer.get_lower_bound(),
+                              outer.get_upper_bound(), inner.get_lower_bound(),
+                              inner.get_upper_bound());
+  }
+  return nullopt;
+}
+
+BitVector evaluate_all(const ASTNode &formula, const Trace &trace) {
+  if (optional<BitVector> fused = evaluate_fused(formula, trace)) {
+    return std::move(*fused);
+  }
+  if (formula.is_unary_op()) {
+    BitVector operand = evaluate_all(
+        static_cast<const UnaryOp &>(formula).get_operand(), trace);
+    return apply_operator(formula, trace, &operand, nullptr);
+  }
+  if (formula.is_binary_op()) {
+    const BinaryOp &op = static_cast<const BinaryOp &>(formula);
+    BitVector left = evaluate_all(op.get_left(), trace);
+    BitVector right = evaluate_all(op.get_right(), trace);
+    return apply_operator(formula, trace, &left, &right);
+  }
+  return apply_operator(formula, trace, nullptr, nullptr);
+}
+
+/* Whether formula has no temporal operators, so that its value at a time step
+ * only depends on the state there.
+ */
+bool is_state_formula(const ASTNode &formula) {
+  if (formula.is_temporal_op()) {
+    return false;
+  }
+  if (formula.is_unary_op()) {
+    return is_state_formula(
+        static_cast<const UnaryOp &>(formula).get_operand());
+  }
+  if (formula.is_binary_op()) {
+    const BinaryOp &op = static_cast<const BinaryOp &>(formula);
+    return is_state_formula(op.get_left()) && is_state_formula(op.get_right());
+  }
+  return true;
+}
+
+/* Bit t of the result is bit ids[t] of values.
+ */
+template <typename Id>
+BitVector gather(const BitVector &values, const vector<Id> &ids) {
+  BitVector result(ids.size());
+  uint64_t *words = result.data();
+  const uint64_t *table = values.data();
+  size_t n = ids.size();
+  for (size_t w = 0; w < result.num_words(); ++w) {
+    size_t begin = w << 6, end = min(begin + 64, n);
+    uint64_t word = 0;
+    for (size_t t = begin; t < end; ++t) {
+      word |= ((table[ids[t] >> 6] >> (ids[t] & 63)) & 1) << (t - begin);
+    }
+    words[w] = word;
+  }
+  return result;
+}
+
+BitVector evaluate_all(const ASTNode &formula, const DictionaryTrace &trace) {
+  if (is_state_formula(formula)) {
+    // once per distinct state, then looked up at every time step
+    BitVector values = evaluate_all(formula, trace.get_states());
+    switch (trace.id_width()) {
+    case 1:
+      return gather(values, trace.get_ids8());
+    case 2:
+      return gather(values, trace.get_ids16());
+    default:
+      return gather(values, trace.get_ids32());
+    }
+  }
+  // temporal operators only read the satisfaction vectors of their operands
+  Trace none;
+  if (formula.is_unary_op()) {
+    BitVector operand = evaluate_all(
+        static_cast<const UnaryOp &>(formula).get_operand(), trace);
+    return apply_operator(formula, none, &operand, nullptr);
+  }
+  const BinaryOp &op = static_cast<const BinaryOp &>(formula);
+  BitVector left = evaluate_all(op.get_left(), trace);
+  BitVector right = evaluate_all(op.get_right(), trace);
+  return apply_operator(formula, none, &left, &right);
+}
+
+size_t evaluation_reach(const ASTNode &formula) {
+  switch (formula.get_type()) {
+  case ASTNode::Type::Constant:
+    return 0;
+  case ASTNode::Type::Variable:
+    return 1;
+  case ASTNode::Type::Negation:
+    return evaluation_reach(
+        static_cast<const UnaryOp &>(formula).get_operand());
+  case ASTNode::Type::Finally:
+  case ASTNode::Type::Globally: {
+    // the whole window [lb, ub] must exist and every operand in it be decided
+    const UnaryTempOp &op = static_cast<const UnaryTempOp &>(formula);
+    size_t operand_reach = evaluation_reach(op.get_operand());
+    return max(op.get_lower_bound() + 1,
+               op.get_upper_bound() + max((size_t)1, operand_reach));
+  }
+  case ASTNode::Type::Until:
+  case ASTNode::Type::Release: {
+    // left is only ever evaluated strictly before the end of the window
+    const BinaryTempOp &op = static_cast<const BinaryTempOp &>(formula);
+    size_t left_reach = evaluation_reach(op.get_left());
+    size_t right_reach = evaluation_reach(op.get_right());
+    size_t reach = max({(size_t)1, right_reach, left_reach - (left_reach > 0)});
+    return max(op.get_lower_bound() + 1, op.get_upper_bound() + reach);
+  }
+  default: {
+    const BinaryOp &op = static_cast<const BinaryOp &>(formula);
+    return max(evaluation_reach(op.get_left()),
+               evaluation_reach(op.get_right()));
+  }
+  }
+}
+
+EvaluationContext::EvaluationContext(
+    const vector<shared_ptr<ASTNode>> &formulas)
+    : formulas(formulas), reach(1) {
+  map<NodeKey, size_t> index;
+  unordered_map<const ASTNode *, size_t> seen;
+  for (const auto &formula : formulas) {
+    roots.push_back(add_node(*formula, index, seen));
+    reach = max(reach, evaluation_reach(*formula));
+  }
+}
+
+size_t
+EvaluationContext::add_node(const ASTNode &formula, map<NodeKey, size_t> &index,
+                            unordered_map<const ASTNode *, size_t> &seen) {
+  auto it = seen.find(&formula);
+  if (it != seen.end()) {
+    return it->second;
+  }
+  // identify the node by its type, payload and (already merged) operands
+  NodeKey key = {(size_t)formula.get_type(), 0, 0, npos, npos};
+  switch (formula.get_type()) {
+  case ASTNode::Type::Constant:
+    key[1] = static_cast<const Constant &>(formula).get_value();
+    break;
+  case ASTNode::Type::Variable:
+    key[1] = static_cast<const Variable &>(formula).get_id();
+    break;
+  case ASTNode::Type::Finally:
+  case ASTNode::Type::Globally:
+    key[1] = static_cast<const UnaryTempOp &>(formula).get_lower_bound();
+    key[2] = static_cast<const UnaryTempOp &>(formula).get_upper_bound();
+    break;
+  case ASTNode::Type::Until:
+  case ASTNode::Type::Release:
+    key[1] = static_cast<const BinaryTempOp &>(formula).get_lower_bound();
+    key[2] = static_cast<const BinaryTempOp &>(formula).get_upper_bound();
+    break;
+  default:
+    break;
+  }
+  if (formula.is_unary_op()) {
+    key[3] = add_node(static_cast<const UnaryOp &>(formula).get_operand(),
+                      index, seen);
+  } else if (formula.is_binary_op()) {
+    const BinaryOp &op = static_cast<const BinaryOp &>(formula);
+    key[3] = add_node(op.get_left(), index, seen);
+    key[4] = add_node(op.get_right(), index, seen);
+  }
+  auto [entry, inserted] = index.emplace(key, nodes.size());
+  if (inserted) {
+    nodes.push_back({&formula, key[3], key[4]});
+  }
+  seen.emplace(&formula, entry->second);
+  return entry->second;
+}
+
+BitVector EvaluationContext::evaluate(const Trace &trace) const {
+  if (trace.size() == 0) {
+    BitVector result(roots.size());
+    for (size_t k = 0; k < roots.size(); ++k) {
+      result.set(k, formulas[k]->evaluate(trace));
+    }
+    return result;
+  }
+  // verdicts at time step 0 are decided by the first reach states
+  Trace prefix;
+  const Trace *input = &trace;
+  if (reach < trace.size()) {
+    prefix = trace.slice(0, reach);
+    input = &prefix;
+  }
+  vector<BitVector> values(nodes.size());
+  for (size_t i = 0; i < nodes.size(); ++i) {
+    const Node &node = nodes[i];
+    values[i] = apply_operator(*node.formula, *input,
+                               node.left == npos ? nullptr : &values[node.left],
+                               node.right == npos ? nullptr
+                                                  : &values[node.right]);
+  }
+  BitVector result(roots.size());
+  for (size_t k = 0; k < roots.size(); ++k) {
+    result.set(k, values[roots[k]][0]);
+  }
+  return result;
+}
+BitVector EvaluationContext::evaluate(const vector<string> &trace) const {
+  return evaluate(Trace(trace));
+}
+
+BitVector evaluate_all(const ASTNode &formula, const vector<string> &trace) {
+  return evaluate_all(formula, Trace(trace));
+}
+
+/* Time steps per chunk unless the caller chooses: large enough that the
+ * overlap and the per chunk setup do not matter for short traces.
+ */
+constexpr size_t min_chunk_size = 65536;
+
+BitVector evaluate_all(const ASTNode &formula, const Trace &trace,
+                       ThreadPool &pool, size_t chunk_size) {
+  size_t n = trace.size();
+  if (chunk_size == 0) {
+    // a few chunks per thread, so stealing can even out the load
+    chunk_size = max(min_chunk_size, (n + 4 * pool.size() - 1) /
+                                         (4 * pool.size()));
+  }
+  if (n <= chunk_size) {
+    return evaluate_all(formula, trace);
+  }
+  // chunks start at multiples of 64, so they write disjoint result words
+  chunk_size = (chunk_size + 63) & ~(size_t)63;
+  // the verdicts at [begin, end) are decided by the states up to
+  // end - 1 + reach, or the end of the trace
+  size_t overlap = max((size_t)1, evaluation_reach(formula)) - 1;
+  BitVector result(n);
+  pool.run((n + chunk_size - 1) / chunk_size, [&](size_t chunk) {
+    size_t begin = chunk * chunk_size;
+    size_t end = min(begin + chunk_size, n);
+    BitVector verdicts = evaluate_all(
+        formula, trace.slice(begin, end + min(overlap, n - end)));
+    copy_n(verdicts.data(), (end - begin + 63) / 64,
+           result.data() + begin / 64);
+  });
+  result.clear_padding();
+  return result;
+}
+BitVector evaluate_all(const ASTNode &formula, const Trace &trace,
+                       unsigned int num_threads, size_t chunk_size) {
+  ThreadPool pool(num_threads);
+  return evaluate_all(formula, trace, pool, chunk_size);
+}
+
+BitVector ASTNode::evaluate_all(const Trace &trace) const {
+  return libmltl::evaluate_all(*this, trace);
+}
+BitVector ASTNode::evaluate_all(const vector<string> &trace) const {
+  return libmltl::evaluate_all(*this, trace);
+}
+
+} // namespace libmltl
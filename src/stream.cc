@@ -0,0 +1,179 @@
+#include "stream.hh"
+#include "satisfaction.hh"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+
+using namespace std;
+namespace libmltl {
+
+/* Splits a stream into lines, reading it in blocks. Like getline, a last line
+ * without a newline is returned if it is not empty.
+ */
+class LineReader {
+private:
+  istream &in;
+  vector<char> block;
+  size_t pos, len;
+  // a line that continues past the end of the block
+  string carry;
+
+public:
+  explicit LineReader(istream &in) : in(in), block(1 << 20), pos(0), len(0) {}
+
+  /* Sets [begin, end) to the next line, without the newline. The range is
+   * valid until the next call. Returns false at the end of the stream.
+   */
+  bool next(const char *&begin, const char *&end) {
+    carry.clear();
+    bool partial = false;
+    while (true) {
+      if (pos == len) {
+        in.read(block.data(), block.size());
+        len = in.gcount();
+        pos = 0;
+        if (len == 0) {
+          begin = carry.data();
+          end = begin + carry.size();
+          return partial;
+        }
+      }
+      const char *first = block.data() + pos;
+      const char *newline = (const char *)memchr(first, '\n', len - pos);
+      if (newline == nullptr) {
+        carry.append(first, len - pos);
+        partial = true;
+        pos = len;
+        continue;
+      }
+      pos = newline - block.data() + 1;
+      if (partial) {
+        carry.append(first, newline - first);
+        begin = carry.data();
+        end = begin + carry.size();
+      } else {
+        begin = first;
+        end = newline;
+      }
+      return true;
+    }
+  }
+};
+
+/* Reads up to count states into time steps [t, t + count) of trace, which is
+ * created with the number of variables of the first state if it has none,
+ * like read_trace_file followed by Trace does. Returns the number of states
+ * read.
+ */
+size_t read_states(LineReader &reader, Trace &trace, size_t &num_vars,
+                   bool &started, size_t t, size_t count, size_t capacity) {
+  const char *begin, *end;
+  size_t read = 0;
+  while (read < count && reader.next(begin, end)) {
+    if (!started) {
+      num_vars =
+          count_if(begin, end, [](char c) { return c == '0' || c == '1'; });
+      trace = Trace(num_vars, capacity);
+      started = true;
+    }
+    // the characters other than 0 and 1 are separators
+    size_t id = 0;
+    for (const char *c = begin; c != end && id < num_vars; ++c) {
+      if (*c == '1') {
+        trace.set(id++, t + read, true);
+      } else if (*c == '0') {
+        ++id;
+      }
+    }
+    ++read;
+  }
+  return read;
+}
+
+double seconds_since(chrono::steady_clock::time_point start) {
+  return chrono::duration<double>(chrono::steady_clock::now() - start).count();
+}
+
+StreamStats evaluate_stream(const ASTNode &formula, istream &trace,
+                            const VerdictSink &sink, size_t window_size) {
+  auto start = chrono::steady_clock::now();
+  // the verdicts of a window are decided by the states up to its end - 1 +
+  // reach, which are kept for the next window
+  size_t overlap = max((size_t)1, evaluation_reach(formula)) - 1;
+  size_t window = (max(window_size, (size_t)1) + 63) & ~(size_t)63;
+  size_t capacity = window + overlap;
+
+  LineReader reader(trace);
+  Trace buffer;
+  size_t num_vars = 0;
+  bool started = false;
+  size_t filled = 0;
+  StreamStats stats = {0, 0};
+  while (true) {
+    size_t read = read_states(reader, buffer, num_vars, started, filled,
+                              capacity - filled, capacity);
+    stats.steps += read;
+    filled += read;
+    if (filled < capacity) {
+      // the trace ends in this window
+      if (filled > 0) {
+        sink(stats.steps - filled,
+             evaluate_all(formula, buffer.slice(0, filled)));
+      }
+      break;
+    }
+    BitVector verdicts = evaluate_all(formula, buffer);
+    sink(stats.steps - filled, verdicts.slice(0, window));
+    Trace next(num_vars, capacity);
+    for (unsigned int id = 0; id < num_vars; ++id) {
+      BitVector &column = next.get_variable(id);
+      column = buffer.get_variable(id).slice(window, capacity);
+      column.resize(capacity);
+    }
+    buffer = std::move(next);
+    filled = overlap;
+  }
+  stats.seconds = seconds_since(start);
+  return stats;
+}
+
+StreamStats evaluate_stream_final(const ASTNode &formula, istream &trace,
+                                  const VerdictSink &sink) {
+  auto start = chrono::steady_clock::now();
+  size_t reach = evaluation_reach(formula);
+  LineReader reader(trace);
+  Trace prefix;
+  size_t num_vars = 0;
+  bool started = false;
+  StreamStats stats = {0, 0};
+  stats.steps =
+      read_states(reader, prefix, num_vars, started, 0, reach, reach);
+  sink(0, BitVector(1, formula.evaluate(prefix.slice(0, stats.steps))));
+  stats.seconds = seconds_since(start);
+  return stats;
+}
+
+StreamStats evaluate_trace_file(const ASTNode &formula,
+                                const string &trace_file_path, ostream &out,
+                                bool all_steps, size_t window_size) {
+  ifstream file(trace_file_path, ios::binary);
+  if (!file.is_open()) {
+    throw runtime_error("cannot open trace file " + trace_file_path);
+  }
+  string text;
+  VerdictSink write = [&](size_t, const BitVector &verdicts) {
+    text.clear();
+    for (size_t i = 0; i < verdicts.size(); ++i) {
+      text.push_back(verdicts[i] ? '1' : '0');
+      text.push_back('\n');
+    }
+    out.write(text.data(), text.size());
+  };
+  return all_steps ? evaluate_stream(formula, file, write, window_size)
+                   : evaluate_stream_final(formula, file, write);
+}
+
+} // namespace libmltl
@@ -0,0 +1,154 @@
+#include "thread_pool.hh"
+
+#include <algorithm>
+#include <stdexcept>
+
+using namespace std;
+namespace libmltl {
+
+/* A pool whose tasks the current thread may run: the pool of a worker thread,
+ * or one whose run() the thread is in. The frames of one thread form a stack.
+ */
+struct PoolFrame {
+  const ThreadPool *pool;
+  const PoolFrame *outer;
+};
+thread_local const PoolFrame *pool_frames = nullptr;
+
+bool in_pool(const ThreadPool *pool) {
+  for (const PoolFrame *frame = pool_frames; frame; frame = frame->outer) {
+    if (frame->pool == pool) {
+      return true;
+    }
+  }
+  return false;
+}
+
+ThreadPool::ThreadPool(unsigned int num_threads)
+    : task(nullptr), generation(0), active(0), stop(false), cancelled(false) {
+  if (num_threads == 0) {
+    num_threads = max(1u, thread::hardware_concurrency());
+  }
+  ranges = make_unique<Range[]>(num_threads);
+  for (size_t i = 0; i < num_threads; ++i) {
+    ranges[i].begin = ranges[i].end = 0;
+  }
+  for (size_t i = 1; i < num_threads; ++i) {
+    threads.emplace_back(&ThreadPool::worker, this, i);
+  }
+}
+
+ThreadPool::~ThreadPool() {
+  {
+    lock_guard<std::mutex> lock(state_mutex);
+    stop = true;
+  }
+  start_cv.notify_all();
+  for (thread &t : threads) {
+    t.join();
+  }
+}
+
+void ThreadPool::worker(size_t self) {
+  PoolFrame frame{this, pool_frames};
+  pool_frames = &frame;
+  size_t seen = 0;
+  while (true) {
+    {
+      unique_lock<std::mutex> lock(state_mutex);
+      start_cv.wait(lock, [&] { return stop || generation != seen; });
+      if (stop) {
+        return;
+      }
+      seen = generation;
+    }
+    work(self);
+    lock_guard<std::mutex> lock(state_mutex);
+    if (--active == 0) {
+      done_cv.notify_one();
+    }
+  }
+}
+
+bool ThreadPool::next_task(size_t self, size_t &t) {
+  if (cancelled) {
+    return false;
+  }
+  {
+    Range &own = ranges[self];
+    lock_guard<std::mutex> lock(own.mutex);
+    if (own.begin < own.end) {
+      t = own.begin++;
+      return true;
+    }
+  }
+  for (size_t i = 1; i < size(); ++i) {
+    Range &victim = ranges[(self + i) % size()];
+    size_t begin, end;
+    {
+      lock_guard<std::mutex> lock(victim.mutex);
+      if (victim.begin >= victim.end) {
+        continue;
+      }
+      // take the upper half, at least the last task
+      begin = victim.begin + (victim.end - victim.begin) / 2;
+      end = victim.end;
+      victim.end = begin;
+    }
+    Range &own = ranges[self];
+    lock_guard<std::mutex> lock(own.mutex);
+    t = begin;
+    own.begin = begin + 1;
+    own.end = end;
+    return true;
+  }
+  return false;
+}
+
+void ThreadPool::work(size_t self) {
+  size_t t;
+  while (next_task(self, t)) {
+    try {
+      (*task)(t);
+    } catch (...) {
+      lock_guard<std::mutex> lock(state_mutex);
+      if (!error) {
+        error = current_exception();
+      }
+      cancelled = true;
+    }
+  }
+}
+
+void ThreadPool::run(size_t num_tasks, const function<void(size_t)> &task) {
+  if (in_pool(this)) {
+    throw logic_error("ThreadPool::run called from one of its own tasks");
+  }
+  lock_guard<std::mutex> run_lock(run_mutex);
+  PoolFrame frame{this, pool_frames};
+  pool_frames = &frame;
+  {
+    lock_guard<std::mutex> lock(state_mutex);
+    this->task = &task;
+    error = nullptr;
+    cancelled = false;
+    for (size_t i = 0; i < size(); ++i) {
+      lock_guard<std::mutex> range_lock(ranges[i].mutex);
+      ranges[i].begin = num_tasks * i / size();
+      ranges[i].end = num_tasks * (i + 1) / size();
+    }
+    active = threads.size();
+    ++generation;
+  }
+  start_cv.notify_all();
+  work(0);
+  unique_lock<std::mutex> lock(state_mutex);
+  done_cv.wait(lock, [&] { return active == 0; });
+  this->task = nullptr;
+  pool_frames = frame.outer;
+  if (error) {
+    rethrow_exception(error);
+  }
+}
+
+} // namespace libmltl
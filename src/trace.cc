@@ -0,0 +1,229 @@
+#include "trace.hh"
+
+using namespace std;
+namespace libmltl {
+
+BitVector::BitVector() : len(0) {}
+BitVector::BitVector(size_t length, bool value)
+    : len(length), words((length + 63) / 64, value ? ~(uint64_t)0 : 0) {
+  clear_padding();
+}
+
+void BitVector::push_back(bool value) {
+  if ((len & 63) == 0) {
+    words.push_back(0);
+  }
+  ++len;
+  set(len - 1, value);
+}
+
+void BitVector::resize(size_t length, bool value) {
+  size_t old_len = len;
+  len = length;
+  words.resize((length + 63) / 64, value ? ~(uint64_t)0 : 0);
+  if (value && old_len < length && (old_len & 63)) {
+    // fill the remainder of the previously last word
+    words[old_len >> 6] |= ~(uint64_t)0 << (old_len & 63);
+  }
+  clear_padding();
+}
+
+BitVector BitVector::slice(size_t begin, size_t end) const {
+  BitVector result(end - begin);
+  size_t first = begin >> 6, shift = begin & 63;
+  for (size_t w = 0; w < result.words.size(); ++w) {
+    uint64_t word = words[first + w] >> shift;
+    if (shift && first + w + 1 < words.size()) {
+      word |= words[first + w + 1] << (64 - shift);
+    }
+    result.words[w] = word;
+  }
+  result.clear_padding();
+  return result;
+}
+
+void BitVector::clear_padding() {
+  if (len & 63) {
+    words.back() &= ((uint64_t)1 << (len & 63)) - 1;
+  }
+}
+
+size_t BitVector::count() const {
+  size_t result = 0;
+  for (uint64_t w : words) {
+    result += __builtin_popcountll(w);
+  }
+  return result;
+}
+
+size_t BitVector::find_next(size_t pos) const {
+  if (pos >= len) {
+    return len;
+  }
+  size_t w = pos >> 6;
+  uint64_t bits = words[w] & (~(uint64_t)0 << (pos & 63));
+  while (bits == 0) {
+    if (++w == words.size()) {
+      return len;
+    }
+    bits = words[w];
+  }
+  return (w << 6) + __builtin_ctzll(bits);
+}
+
+size_t BitVector::find_next_unset(size_t pos) const {
+  if (pos >= len) {
+    return len;
+  }
+  size_t w = pos >> 6;
+  uint64_t bits = ~words[w] & (~(uint64_t)0 << (pos & 63));
+  while (bits == 0) {
+    if (++w == words.size()) {
+      return len;
+    }
+    bits = ~words[w];
+  }
+  // padding bits are zero, so an unset bit may be found past the end
+  return min((w << 6) + __builtin_ctzll(bits), len);
+}
+
+string BitVector::as_string() const {
+  string result(len, '0');
+  for (size_t i = 0; i < len; ++i) {
+    if (get(i)) {
+      result[i] = '1';
+    }
+  }
+  return result;
+}
+
+bool BitVector::operator==(const BitVector &other) const {
+  return len == other.len && words == other.words;
+}
+
+Trace::Trace() : len(0) {}
+Trace::Trace(size_t num_vars, size_t length)
+    : len(length), columns(num_vars, BitVector(length)) {}
+Trace::Trace(const vector<string> &trace) : len(0) {
+  if (!trace.empty()) {
+    columns.assign(trace[0].length(), BitVector(trace.size()));
+  }
+  for (const string &state : trace) {
+    size_t width = min(state.length(), columns.size());
+    for (size_t id = 0; id < width; ++id) {
+      if (state[id] == '1') {
+        columns[id].set(len, true);
+      }
+    }
+    ++len;
+  }
+}
+
+void Trace::push_back(const string &state) {
+  if (len == 0 && columns.empty()) {
+    columns.resize(state.length());
+  }
+  for (size_t id = 0; id < columns.size(); ++id) {
+    columns[id].push_back(id < state.length() && state[id] == '1');
+  }
+  ++len;
+}
+
+Trace Trace::slice(size_t begin, size_t end) const {
+  Trace result;
+  result.len = end - begin;
+  for (const BitVector &column : columns) {
+    result.columns.push_back(column.slice(begin, end));
+  }
+  return result;
+}
+
+string Trace::get_state(size_t t) const {
+  string result(columns.size(), '0');
+  for (size_t id = 0; id < columns.size(); ++id) {
+    if (columns[id].get(t)) {
+      result[id] = '1';
+    }
+  }
+  return result;
+}
+
+vector<string> Trace::as_strings() const {
+  vector<string> result;
+  result.reserve(len);
+  for (size_t t = 0; t < len; ++t) {
+    result.emplace_back(get_state(t));
+  }
+  return result;
+}
+
+DictionaryTrace::DictionaryTrace() : len(0) {}
+DictionaryTrace::DictionaryTrace(const vector<string> &trace)
+    : DictionaryTrace() {
+  for (const string &state : trace) {
+    push_back(state);
+  }
+}
+DictionaryTrace::DictionaryTrace(const Trace &trace) : DictionaryTrace() {
+  for (size_t t = 0; t < trace.size(); ++t) {
+    push_back(trace.get_state(t));
+  }
+}
+
+void DictionaryTrace::push_back(const string &state) {
+  // the state as Trace stores it, so states that read the same share an id
+  string key(len > 0 ? num_vars() : state.length(), '0');
+  for (size_t id = 0; id < key.length() && id < state.length(); ++id) {
+    if (state[id] == '1') {
+      key[id] = '1';
+    }
+  }
+  auto [entry, inserted] = index.emplace(key, num_states());
+  if (inserted) {
+    states.push_back(key);
+    // widen the ids when they no longer fit
+    if (num_states() == 257) {
+      ids16.assign(ids8.begin(), ids8.end());
+      ids8 = vector<uint8_t>();
+    } else if (num_states() == 65537) {
+      ids32.assign(ids16.begin(), ids16.end());
+      ids16 = vector<uint16_t>();
+    }
+  }
+  switch (id_width()) {
+  case 1:
+    ids8.push_back(entry->second);
+    break;
+  case 2:
+    ids16.push_back(entry->second);
+    break;
+  default:
+    ids32.push_back(entry->second);
+    break;
+  }
+  ++len;
+}
+
+vector<string> DictionaryTrace::as_strings() const {
+  vector<string> result;
+  result.reserve(len);
+  for (size_t t = 0; t < len; ++t) {
+    result.emplace_back(get_state(t));
+  }
+  return result;
+}
+
+Trace DictionaryTrace::to_trace() const {
+  Trace result(num_vars(), len);
+  for (size_t t = 0; t < len; ++t) {
+    size_t id = get_id(t);
+    for (unsigned int var = 0; var < num_vars(); ++var) {
+      if (states.get(var, id)) {
+        result.set(var, t, true);
+      }
+    }
+  }
+  return result;
+}
+
+} // namespace libmltl
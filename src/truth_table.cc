@@ -0,0 +1,98 @@
+#include "truth_table.hh"
+#include "satisfaction.hh"
+
+#include <algorithm>
+#include <stdexcept>
+
+using namespace std;
+namespace libmltl {
+
+/* Appends the ids of the variables of formula to vars. Returns false if
+ * formula has a temporal operator.
+ */
+bool collect_vars(const ASTNode &formula, vector<unsigned int> &vars) {
+  if (formula.is_temporal_op()) {
+    return false;
+  }
+  switch (formula.get_type()) {
+  case ASTNode::Type::Constant:
+    return true;
+  case ASTNode::Type::Variable:
+    vars.push_back(static_cast<const Variable &>(formula).get_id());
+    return true;
+  case ASTNode::Type::Negation:
+    return collect_vars(static_cast<const UnaryOp &>(formula).get_operand(),
+                        vars);
+  default: {
+    const BinaryOp &op = static_cast<const BinaryOp &>(formula);
+    return collect_vars(op.get_left(), vars) &&
+           collect_vars(op.get_right(), vars);
+  }
+  }
+}
+
+/* The distinct variables of formula in increasing order, or false if it has
+ * a temporal operator.
+ */
+bool distinct_vars(const ASTNode &formula, vector<unsigned int> &vars) {
+  if (!collect_vars(formula, vars)) {
+    return false;
+  }
+  sort(vars.begin(), vars.end());
+  vars.erase(unique(vars.begin(), vars.end()), vars.end());
+  return true;
+}
+
+/* Replaces the id of every variable of formula, a formula without temporal
+ * operators, by its index in vars.
+ */
+void renumber_vars(ASTNode &formula, const vector<unsigned int> &vars) {
+  switch (formula.get_type()) {
+  case ASTNode::Type::Constant:
+    return;
+  case ASTNode::Type::Variable: {
+    Variable &var = static_cast<Variable &>(formula);
+    var.set_id(lower_bound(vars.begin(), vars.end(), var.get_id()) -
+               vars.begin());
+    return;
+  }
+  case ASTNode::Type::Negation:
+    renumber_vars(static_cast<UnaryOp &>(formula).get_operand(), vars);
+    return;
+  default: {
+    BinaryOp &op = static_cast<BinaryOp &>(formula);
+    renumber_vars(op.get_left(), vars);
+    renumber_vars(op.get_right(), vars);
+  }
+  }
+}
+
+bool is_tabulable(const ASTNode &formula) {
+  vector<unsigned int> vars;
+  return distinct_vars(formula, vars) && vars.size() <= TruthTable::max_vars;
+}
+
+TruthTable::TruthTable() : table(1) {}
+
+TruthTable::TruthTable(const ASTNode &formula) {
+  if (!distinct_vars(formula, vars) || vars.size() > max_vars) {
+    throw invalid_argument("cannot tabulate " + formula.as_string());
+  }
+  // time step i assigns bit k of i to variable k of a copy of formula in
+  // which vars[k] is renumbered to k, so the trace has one column per
+  // variable however large the ids are
+  shared_ptr<ASTNode> dense = formula.deep_copy();
+  renumber_vars(*dense, vars);
+  size_t size = (size_t)1 << vars.size();
+  Trace assignments(vars.size(), size);
+  for (size_t k = 0; k < vars.size(); ++k) {
+    for (size_t i = 0; i < size; ++i) {
+      if ((i >> k) & 1) {
+        assignments.set(k, i, true);
+      }
+    }
+  }
+  table = evaluate_all(*dense, assignments);
+}
+
+} // namespace libmltl
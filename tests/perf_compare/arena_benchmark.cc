@@ -0,0 +1,252 @@
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <sys/time.h>
+
+#include "parser.hh"
+
+using namespace std;
+using namespace libmltl;
+
+// every heap allocation of the program goes through here
+size_t num_allocations = 0;
+
+void *operator new(size_t size) {
+  ++num_allocations;
+  if (void *p = malloc(size ? size : 1)) {
+    return p;
+  }
+  throw bad_alloc();
+}
+void operator delete(void *p) noexcept { free(p); }
+void operator delete(void *p, size_t) noexcept { free(p); }
+
+double seconds_since(const struct timeval &start) {
+  struct timeval end;
+  gettimeofday(&end, NULL);
+  return (end.tv_sec - start.tv_sec) + (end.tv_usec - start.tv_usec) / 1e6;
+}
+
+/* Prints the allocations and time of work, and of releasing what it made
+ * with release.
+ */
+template <typename Work, typename Release>
+void measure(const string &name, size_t num_nodes, Work work,
+             Release release) {
+  struct timeval start;
+  size_t allocations = num_allocations;
+  gettimeofday(&start, NULL); // start timer
+  work();
+  double work_time = seconds_since(start);
+  allocations = num_allocations - allocations;
+  gettimeofday(&start, NULL); // start timer
+  release();
+  double release_time = seconds_since(start);
+  cout << "  " << name << ": " << allocations << " allocations ("
+       << (double)allocations / num_nodes << " per node), " << work_time
+       << "s, release " << release_time << "s\n";
+}
+
+/* Every F, G, ~, & and U over the formulas of the previous depth, like the
+ * formula generation of the regression tests. make(type, left, right,
+ * value) makes a node.
+ */
+template <typename Make>
+void generate(vector<shared_ptr<ASTNode>> &formulas, int depth, Make make) {
+  for (int i = 0; i < 3; ++i) {
+    formulas.push_back(make(ASTNode::Type::Variable, nullptr, nullptr, i));
+  }
+  size_t begin = 0;
+  for (int d = 1; d <= depth; ++d) {
+    size_t end = formulas.size();
+    for (size_t i = begin; i < end; ++i) {
+      formulas.push_back(
+          make(ASTNode::Type::Negation, formulas[i], nullptr, 0));
+      for (size_t ub = 0; ub <= 2; ++ub) {
+        formulas.push_back(
+            make(ASTNode::Type::Finally, formulas[i], nullptr, ub));
+        formulas.push_back(
+            make(ASTNode::Type::Globally, formulas[i], nullptr, ub));
+      }
+    }
+    for (size_t i = begin; i < end; ++i) {
+      for (size_t j = begin; j < end; j += 7) {
+        formulas.push_back(
+            make(ASTNode::Type::And, formulas[i], formulas[j], 0));
+        formulas.push_back(
+            make(ASTNode::Type::Until, formulas[i], formulas[j], 1));
+      }
+    }
+    begin = end;
+  }
+}
+
+/* Makes a node of the generation above with make_shared, or in arena.
+ */
+shared_ptr<ASTNode> make_generated(ASTArena *arena, ASTNode::Type type,
+                                   shared_ptr<ASTNode> left,
+                                   shared_ptr<ASTNode> right, size_t value) {
+  switch (type) {
+  case ASTNode::Type::Variable:
+    return make_node<Variable>(arena, (unsigned int)value);
+  case ASTNode::Type::Negation:
+    return make_node<Negation>(arena, left);
+  case ASTNode::Type::Finally:
+    return make_node<Finally>(arena, left, (size_t)0, value);
+  case ASTNode::Type::Globally:
+    return make_node<Globally>(arena, left, (size_t)0, value);
+  case ASTNode::Type::And:
+    return make_node<And>(arena, left, right);
+  default:
+    return make_node<Until>(arena, left, right, (size_t)0, value);
+  }
+}
+
+int main() {
+  vector<string> formulas_str;
+  ifstream file("MLTL_interpreter/formulas.txt");
+  string line;
+  while (getline(file, line)) {
+    formulas_str.push_back(line);
+  }
+  if (formulas_str.empty()) {
+    cerr << "Unable to open file formulas.txt\n";
+    return 1;
+  }
+  const int repetitions = 100;
+  size_t num_nodes = 0;
+  for (const string &f : formulas_str) {
+    num_nodes += parse(f)->size() * repetitions;
+  }
+  cout << "Parsing " << formulas_str.size() << " formulas " << repetitions
+       << " times (" << num_nodes << " nodes)\n";
+
+  // reserved, so that only the nodes are counted
+  vector<shared_ptr<ASTNode>> heap;
+  heap.reserve(formulas_str.size() * repetitions);
+  measure(
+      "parse          ", num_nodes,
+      [&] {
+        for (int r = 0; r < repetitions; ++r) {
+          for (const string &f : formulas_str) {
+            heap.push_back(parse(f));
+          }
+        }
+      },
+      [&] { heap.clear(); });
+  ASTArena arena;
+  vector<shared_ptr<ASTNode>> in_arena;
+  in_arena.reserve(formulas_str.size() * repetitions);
+  measure(
+      "parse, arena   ", num_nodes,
+      [&] {
+        for (int r = 0; r < repetitions; ++r) {
+          for (const string &f : formulas_str) {
+            in_arena.push_back(parse(f, arena));
+          }
+        }
+      },
+      [&] {
+        in_arena.clear();
+        arena.clear();
+      });
+
+  // repeated formulas and subformulas are made once
+  FormulaFactory factory;
+  size_t num_distinct = 0;
+  measure(
+      "parse, factory ", num_nodes,
+      [&] {
+        for (int r = 0; r < repetitions; ++r) {
+          for (const string &f : formulas_str) {
+            heap.push_back(parse(f, factory));
+          }
+        }
+        num_distinct = factory.size();
+      },
+      [&] {
+        heap.clear();
+        factory.clear();
+      });
+  cout << "  (" << num_distinct << " distinct nodes)\n";
+
+  vector<shared_ptr<ASTNode>> originals;
+  for (const string &f : formulas_str) {
+    originals.push_back(parse(f));
+  }
+  measure(
+      "deep_copy      ", num_nodes,
+      [&] {
+        for (int r = 0; r < repetitions; ++r) {
+          for (const auto &formula : originals) {
+            heap.push_back(formula->deep_copy());
+          }
+        }
+      },
+      [&] { heap.clear(); });
+  measure(
+      "deep_copy arena", num_nodes,
+      [&] {
+        for (int r = 0; r < repetitions; ++r) {
+          for (const auto &formula : originals) {
+            in_arena.push_back(formula->deep_copy(arena));
+          }
+        }
+      },
+      [&] {
+        in_arena.clear();
+        arena.clear();
+      });
+
+  // copies of heap pointers count references, those of unique formulas do not
+  vector<UniqueFormula> unique;
+  for (const auto &formula : originals) {
+    unique.emplace_back(*formula);
+  }
+  cout << "Copying " << originals.size() << " pointers " << 10 * repetitions
+       << " times\n";
+  vector<shared_ptr<ASTNode>> copies;
+  copies.reserve(originals.size() * 10 * repetitions);
+  measure(
+      "shared_ptr     ", copies.capacity(),
+      [&] {
+        for (int r = 0; r < 10 * repetitions; ++r) {
+          copies.insert(copies.end(), originals.begin(), originals.end());
+        }
+      },
+      [&] { copies.clear(); });
+  measure(
+      "UniqueFormula  ", copies.capacity(),
+      [&] {
+        for (int r = 0; r < 10 * repetitions; ++r) {
+          for (const auto &formula : unique) {
+            copies.push_back(formula.handle());
+          }
+        }
+      },
+      [&] { copies.clear(); });
+
+  // the generated formulas share their operands, so there is one node each
+  vector<shared_ptr<ASTNode>> generated;
+  auto generate_into = [&](ASTArena *arena) {
+    generate(generated, 3, [&](auto... args) {
+      return make_generated(arena, args...);
+    });
+  };
+  generate_into(nullptr);
+  size_t num_generated = generated.size();
+  generated.clear();
+  generated.reserve(num_generated);
+  cout << "Generating " << num_generated << " formulas\n";
+  measure(
+      "generate       ", num_generated, [&] { generate_into(nullptr); },
+      [&] { generated.clear(); });
+  measure(
+      "generate, arena", num_generated, [&] { generate_into(&arena); },
+      [&] {
+        generated.clear();
+        arena.clear();
+      });
+
+  return 0;
+}
@@ -5,8 +5,12 @@
 #include <regex>
 #include <sys/time.h>
 
+#include "batch.hh"
+#include "compiled.hh"
 #include "evaluate_mltl.h"
+#include "monitor.hh"
 #include "parser.hh"
+#include "satisfaction.hh"
 
 using namespace std;
 using namespace libmltl;
@@ -30,6 +34,8 @@ int main(int argc, char *argv[]) {
   double time_taken = 0;
 
   vector<vector<string>> traces;
+  vector<Trace> packed_traces;
+  vector<TraceBatch> batches;
 
   vector<string> formulas_str;
   ifstream file("MLTL_interpreter/formulas.txt");
@@ -61,6 +67,12 @@ int main(int argc, char *argv[]) {
 
   int timeout = 60;
   bool libmltl_eval_timeout = false;
+  bool libmltl_memo_timeout = false;
+  bool libmltl_compiled_timeout = false;
+  bool libmltl_eval_all_timeout = false;
+  bool libmltl_monitor_timeout = false;
+  bool libmltl_batch_timeout = false;
+  bool libmltl_context_timeout = false;
   bool libmltl_parse_eval_timeout = false;
   bool mltl_eval_timeout = false;
 
@@ -74,6 +86,11 @@ int main(int argc, char *argv[]) {
       }
       traces.emplace_back(new_trace);
     }
+    packed_traces = vector<Trace>(traces.begin(), traces.end());
+    batches.clear();
+    for (size_t i = 0; i < num_traces; i += 256) {
+      batches.emplace_back(packed_traces, i, min(i + 256, (size_t)num_traces));
+    }
 
     for (string &f : formulas_str) {
       f = replace_bounds(f, trace_length / 2);
@@ -85,6 +102,8 @@ int main(int argc, char *argv[]) {
     }
 
     cout << "Running benchmarks for trace length " << trace_length << "\n";
+    // reference for the reported speedups, 0 once evaluate times out
+    double evaluate_time = 0;
 
     if (!libmltl_eval_timeout) {
       gettimeofday(&start, NULL); // start timer
@@ -97,9 +116,132 @@ int main(int argc, char *argv[]) {
       time_taken = end.tv_sec + end.tv_usec / 1e6 - start.tv_sec -
                    start.tv_usec / 1e6; // in seconds
       cout << "  [libmltl] formula evaluation took   : " << time_taken << "s\n";
+      evaluate_time = time_taken;
       libmltl_eval_timeout = (end.tv_sec - start.tv_sec > timeout);
     }
 
+    if (!libmltl_compiled_timeout) {
+      vector<CompiledFormula> compiled;
+      for (const auto &formula : formulas) {
+        compiled.emplace_back(*formula);
+      }
+      gettimeofday(&start, NULL); // start timer
+      for (size_t i = 0; i < formulas.size(); ++i) {
+        for (size_t j = 0; j < num_traces; ++j) {
+          compiled[i].evaluate(packed_traces[j]);
+        }
+      }
+      gettimeofday(&end, NULL); // stop timer
+      double compiled_time = end.tv_sec + end.tv_usec / 1e6 - start.tv_sec -
+                             start.tv_usec / 1e6; // in seconds
+      cout << "  [libmltl] compiled formula took     : " << compiled_time
+           << "s";
+      if (evaluate_time > 0) {
+        cout << " (" << evaluate_time / compiled_time << "x vs evaluate)";
+      }
+      cout << "\n";
+      libmltl_compiled_timeout = (end.tv_sec - start.tv_sec > timeout);
+    }
+
+    if (!libmltl_memo_timeout) {
+      gettimeofday(&start, NULL); // start timer
+      for (size_t i = 0; i < formulas.size(); ++i) {
+        for (size_t j = 0; j < num_traces; ++j) {
+          formulas[i]->evaluate_memoized(packed_traces[j]);
+        }
+      }
+      gettimeofday(&end, NULL); // stop timer
+      time_taken = end.tv_sec + end.tv_usec / 1e6 - start.tv_sec -
+                   start.tv_usec / 1e6; // in seconds
+      cout << "  [libmltl] memoized evaluation took  : " << time_taken << "s\n";
+      libmltl_memo_timeout = (end.tv_sec - start.tv_sec > timeout);
+    }
+
+    if (!libmltl_eval_all_timeout) {
+      gettimeofday(&start, NULL); // start timer
+      for (size_t i = 0; i < formulas.size(); ++i) {
+        for (size_t j = 0; j < num_traces; ++j) {
+          evaluate_all(*formulas[i], packed_traces[j]);
+        }
+      }
+      gettimeofday(&end, NULL); // stop timer
+      time_taken = end.tv_sec + end.tv_usec / 1e6 - start.tv_sec -
+                   start.tv_usec / 1e6; // in seconds
+      cout << "  [libmltl] evaluate_all (bottom-up)  : " << time_taken << "s\n";
+
+      vector<DictionaryTrace> dictionary_traces(traces.begin(), traces.end());
+      gettimeofday(&start, NULL); // start timer
+      for (size_t i = 0; i < formulas.size(); ++i) {
+        for (size_t j = 0; j < num_traces; ++j) {
+          evaluate_all(*formulas[i], dictionary_traces[j]);
+        }
+      }
+      gettimeofday(&end, NULL); // stop timer
+      time_taken = end.tv_sec + end.tv_usec / 1e6 - start.tv_sec -
+                   start.tv_usec / 1e6; // in seconds
+      cout << "  [libmltl] evaluate_all (dictionary) : " << time_taken << "s\n";
+      libmltl_eval_all_timeout = (end.tv_sec - start.tv_sec > timeout);
+    }
+
+    if (!libmltl_monitor_timeout) {
+      // the monitor decides every time step, like evaluate_all
+      gettimeofday(&start, NULL); // start timer
+      for (size_t i = 0; i < formulas.size(); ++i) {
+        Monitor monitor(*formulas[i]);
+        for (size_t j = 0; j < num_traces; ++j) {
+          monitor.reset();
+          for (const string &state : traces[j]) {
+            monitor.push(state);
+          }
+          monitor.truncated_verdicts();
+        }
+      }
+      gettimeofday(&end, NULL); // stop timer
+      time_taken = end.tv_sec + end.tv_usec / 1e6 - start.tv_sec -
+                   start.tv_usec / 1e6; // in seconds
+      cout << "  [libmltl] online monitor took       : " << time_taken << "s ("
+           << time_taken * 1e9 / (formulas.size() * num_traces * trace_length)
+           << "ns/state)\n";
+      libmltl_monitor_timeout = (end.tv_sec - start.tv_sec > timeout);
+    }
+
+    if (!libmltl_batch_timeout) {
+      gettimeofday(&start, NULL); // start timer
+      for (size_t i = 0; i < formulas.size(); ++i) {
+        for (const TraceBatch &batch : batches) {
+          evaluate_batch(*formulas[i], batch);
+        }
+      }
+      gettimeofday(&end, NULL); // stop timer
+      time_taken = end.tv_sec + end.tv_usec / 1e6 - start.tv_sec -
+                   start.tv_usec / 1e6; // in seconds
+      cout << "  [libmltl] evaluate_batch (256/batch): " << time_taken << "s\n";
+
+      ThreadPool pool;
+      gettimeofday(&start, NULL); // start timer
+      evaluate_batch(formulas, packed_traces, pool);
+      gettimeofday(&end, NULL); // stop timer
+      time_taken = end.tv_sec + end.tv_usec / 1e6 - start.tv_sec -
+                   start.tv_usec / 1e6; // in seconds
+      cout << "  [libmltl] evaluate_batch matrix (" << pool.size()
+           << " threads): " << time_taken << "s\n";
+      libmltl_batch_timeout = (end.tv_sec - start.tv_sec > timeout);
+    }
+
+    if (!libmltl_context_timeout) {
+      EvaluationContext context(formulas);
+      gettimeofday(&start, NULL); // start timer
+      for (size_t j = 0; j < num_traces; ++j) {
+        context.evaluate(packed_traces[j]);
+      }
+      gettimeofday(&end, NULL); // stop timer
+      time_taken = end.tv_sec + end.tv_usec / 1e6 - start.tv_sec -
+                   start.tv_usec / 1e6; // in seconds
+      cout << "  [libmltl] evaluation context (" << context.num_nodes()
+           << " nodes): " << time_taken << "s\n";
+      libmltl_context_timeout = (end.tv_sec - start.tv_sec > timeout);
+    }
+
     if (!libmltl_parse_eval_timeout) {
       gettimeofday(&start, NULL); // start timer
       for (size_t i = 0; i < formulas.size(); ++i) {
@@ -0,0 +1,121 @@
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <sys/time.h>
+
+#include "flat.hh"
+#include "parser.hh"
+
+using namespace std;
+using namespace libmltl;
+
+double seconds_since(const struct timeval &start) {
+  struct timeval end;
+  gettimeofday(&end, NULL);
+  return (end.tv_sec - start.tv_sec) + (end.tv_usec - start.tv_usec) / 1e6;
+}
+
+/* Prints the time of work, which returns a value to print along, as the best
+ * of a few runs.
+ */
+template <typename Work>
+void measure(const string &name, size_t num_nodes, Work work) {
+  double best = 1e9;
+  size_t result = 0;
+  for (int run = 0; run < 3; ++run) {
+    struct timeval start;
+    gettimeofday(&start, NULL); // start timer
+    result = work();
+    best = min(best, seconds_since(start));
+  }
+  cout << "  " << name << ": " << best << "s, " << num_nodes / best / 1e6
+       << " Mnodes/s (" << result << ")\n";
+}
+
+int main() {
+  vector<string> formulas_str;
+  ifstream file("MLTL_interpreter/formulas.txt");
+  string line;
+  while (getline(file, line)) {
+    formulas_str.push_back(line);
+  }
+  if (formulas_str.empty()) {
+    cerr << "Unable to open file formulas.txt\n";
+    return 1;
+  }
+
+  // sorting and deduplicating many formulas compares them structurally
+  vector<shared_ptr<ASTNode>> set;
+  size_t set_nodes = 0;
+  for (int r = 0; r < 100; ++r) {
+    for (const string &f : formulas_str) {
+      set.push_back(parse(f));
+      set_nodes += set.back()->size();
+    }
+  }
+  cout << "Sorting " << set.size() << " formulas (" << set_nodes
+       << " nodes)\n";
+  measure("sort, unique   ", set_nodes, [&] {
+    vector<shared_ptr<ASTNode>> sorted = set;
+    sort(sorted.begin(), sorted.end(),
+         [](const auto &a, const auto &b) { return *a < *b; });
+    return (size_t)(unique(sorted.begin(), sorted.end(),
+                           [](const auto &a, const auto &b) {
+                             return *a == *b;
+                           }) -
+                    sorted.begin());
+  });
+
+  // one large formula, the conjunction of the file parsed many times
+  const size_t target_nodes = 4000000;
+  vector<shared_ptr<ASTNode>> parts;
+  size_t num_nodes = 0;
+  for (size_t i = 0; num_nodes < target_nodes; ++i) {
+    parts.push_back(parse(formulas_str[i % formulas_str.size()]));
+    num_nodes += parts.back()->size();
+  }
+  while (parts.size() > 1) {
+    vector<shared_ptr<ASTNode>> next;
+    for (size_t i = 0; i + 1 < parts.size(); i += 2) {
+      next.push_back(make_shared<And>(parts[i], parts[i + 1]));
+    }
+    if (parts.size() % 2) {
+      next.push_back(parts.back());
+    }
+    parts = next;
+  }
+  shared_ptr<ASTNode> formula = parts[0];
+  shared_ptr<ASTNode> copy = formula->deep_copy();
+  num_nodes = formula->size();
+  cout << "Formula of " << num_nodes << " nodes\n";
+
+  FlatFormula flat, flat_copy;
+  measure("flatten        ", num_nodes, [&] {
+    flat = FlatFormula(*formula);
+    return flat.size();
+  });
+  flat_copy = FlatFormula(*copy);
+  measure("to_ast         ", num_nodes, [&] { return flat.to_ast()->size(); });
+
+  cout << "ASTNode\n";
+  measure("size           ", num_nodes, [&] { return formula->size(); });
+  measure("depth          ", num_nodes, [&] { return formula->depth(); });
+  measure("count          ", num_nodes,
+          [&] { return formula->count(ASTNode::Type::Finally); });
+  measure("future_reach   ", num_nodes,
+          [&] { return formula->future_reach(); });
+  measure("==             ", num_nodes,
+          [&] { return (size_t)(*formula == *copy); });
+  measure("<              ", num_nodes,
+          [&] { return (size_t)(*formula < *copy); });
+  cout << "FlatFormula\n";
+  measure("size           ", num_nodes, [&] { return flat.size(); });
+  measure("depth          ", num_nodes, [&] { return flat.depth(); });
+  measure("count          ", num_nodes,
+          [&] { return flat.count(ASTNode::Type::Finally); });
+  measure("future_reach   ", num_nodes, [&] { return flat.future_reach(); });
+  measure("==             ", num_nodes,
+          [&] { return (size_t)(flat == flat_copy); });
+
+  return 0;
+}
@@ -0,0 +1,120 @@
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <regex>
+#include <sys/time.h>
+
+#include "compiled.hh"
+#include "jit.hh"
+#include "parser.hh"
+
+using namespace std;
+using namespace libmltl;
+
+double seconds_since(const struct timeval &start) {
+  struct timeval end;
+  gettimeofday(&end, NULL);
+  return end.tv_sec + end.tv_usec / 1e6 - start.tv_sec - start.tv_usec / 1e6;
+}
+
+/* Average time per trace of eval over all traces.
+ */
+template <typename Eval>
+double time_per_trace(const vector<Trace> &traces, Eval eval) {
+  struct timeval start;
+  size_t repetitions = 0;
+  gettimeofday(&start, NULL);
+  do {
+    for (const Trace &trace : traces) {
+      eval(trace);
+    }
+    ++repetitions;
+  } while (seconds_since(start) < 0.2);
+  return seconds_since(start) / (repetitions * traces.size());
+}
+
+int main(int argc, char *argv[]) {
+  const vector<int> trace_length_arr = {64, 256, 1024};
+  const int num_traces = 512;
+  const int num_var = 4;
+  const size_t num_formulas = 8;
+
+  // the largest formulas of the benchmark set
+  vector<string> formulas_str;
+  ifstream file("MLTL_interpreter/formulas.txt");
+  string line;
+  if (!file.is_open()) {
+    std::cerr << "Unable to open file formulas.txt\n";
+    return 1;
+  }
+  while (std::getline(file, line)) {
+    line.erase(remove_if(line.begin(), line.end(),
+                         [](unsigned char c) { return isspace(c); }),
+               line.end());
+    formulas_str.push_back(line);
+  }
+  stable_sort(formulas_str.begin(), formulas_str.end(),
+              [](const string &a, const string &b) {
+                return parse(a)->size() > parse(b)->size();
+              });
+  formulas_str.resize(num_formulas);
+
+  // a fresh cache, so the first instance of every formula is compiled
+  filesystem::path cache_dir =
+      filesystem::temp_directory_path() /
+      ("libmltl-jit-benchmark-" + to_string(time(NULL)));
+
+  mt19937 mt(0);
+  for (int trace_length : trace_length_arr) {
+    vector<Trace> traces;
+    for (int i = 0; i < num_traces; ++i) {
+      vector<string> trace;
+      for (int j = 0; j < trace_length; ++j) {
+        trace.emplace_back(int_to_bin_str(mt(), num_var));
+      }
+      traces.emplace_back(trace);
+    }
+    cout << "Running JIT benchmarks for trace length " << trace_length
+         << " (per trace times in us)\n";
+    regex re("\\[0,\\d+\\]");
+    string bounds = "[0," + to_string(trace_length / 2) + "]";
+    for (const string &f : formulas_str) {
+      shared_ptr<ASTNode> formula = parse(regex_replace(f, re, bounds));
+      CompiledFormula compiled(*formula);
+      struct timeval start;
+      gettimeofday(&start, NULL);
+      JitFormula jit(*formula, cache_dir.string());
+      double compile_time = seconds_since(start);
+      gettimeofday(&start, NULL);
+      JitFormula reloaded(*formula, cache_dir.string());
+      double load_time = seconds_since(start);
+
+      double ast_time = time_per_trace(
+          traces, [&](const Trace &trace) { formula->evaluate(trace); });
+      double compiled_time = time_per_trace(
+          traces, [&](const Trace &trace) { compiled.evaluate(trace); });
+      double jit_time = time_per_trace(
+          traces, [&](const Trace &trace) { jit.evaluate(trace); });
+
+      cout << "  " << formula->as_string() << "\n";
+      cout << "    compile: " << compile_time * 1e3
+           << "ms, load from cache: " << load_time * 1e3 << "ms\n";
+      cout << "    evaluate: " << ast_time * 1e6
+           << ", compiled formula: " << compiled_time * 1e6
+           << ", JIT: " << jit_time * 1e6 << "\n";
+      if (jit_time < ast_time) {
+        // number of trace evaluations that pay for the compilation
+        cout << "    break-even vs evaluate after "
+             << (size_t)(compile_time / (ast_time - jit_time)) + 1
+             << " traces\n";
+      } else {
+        cout << "    JIT is not faster than evaluate\n";
+      }
+    }
+  }
+  filesystem::remove_all(cache_dir);
+
+  return 0;
+}
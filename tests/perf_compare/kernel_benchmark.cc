@@ -0,0 +1,144 @@
+#include <iostream>
+#include <random>
+#include <sys/time.h>
+
+#include "kernels.hh"
+
+using namespace std;
+using namespace libmltl;
+
+typedef void (*BinaryKernel)(uint64_t *, const uint64_t *, const uint64_t *,
+                             size_t);
+
+/* Runs kernel repeatedly over num_words words and returns the throughput in
+ * GB/s, counting every word read and written.
+ */
+double measure(BinaryKernel kernel, uint64_t *dst, const uint64_t *a,
+               const uint64_t *b, size_t num_words, int words_touched) {
+  struct timeval start, end;
+  // aim for ~4 GB of traffic per measurement
+  size_t bytes = num_words * 8 * words_touched;
+  size_t repetitions = max((size_t)1, ((size_t)4 << 30) / bytes);
+  kernel(dst, a, b, num_words); // warm up
+  gettimeofday(&start, NULL);   // start timer
+  for (size_t i = 0; i < repetitions; ++i) {
+    kernel(dst, a, b, num_words);
+  }
+  gettimeofday(&end, NULL); // stop timer
+  double time_taken = end.tv_sec + end.tv_usec / 1e6 - start.tv_sec -
+                      start.tv_usec / 1e6; // in seconds
+  return repetitions * bytes / time_taken / 1e9;
+}
+
+/* Runs evaluate at least 5 times and for at least half a second, and returns
+ * the time per run in ms.
+ */
+template <typename F> double measure_ms(F evaluate) {
+  struct timeval start, end;
+  size_t repetitions = 0;
+  double time_taken = 0;
+  gettimeofday(&start, NULL); // start timer
+  while (repetitions < 5 || time_taken < 0.5) {
+    evaluate();
+    ++repetitions;
+    gettimeofday(&end, NULL);
+    time_taken = end.tv_sec + end.tv_usec / 1e6 - start.tv_sec -
+                 start.tv_usec / 1e6; // in seconds
+  }
+  return time_taken / repetitions * 1e3;
+}
+
+int main(int argc, char *argv[]) {
+  // trace lengths: fits in L2, fits in L3, main memory
+  const vector<size_t> trace_length_arr = {(size_t)1 << 20, (size_t)1 << 24,
+                                           (size_t)1 << 28};
+  const vector<pair<SimdLevel, string>> levels = {
+      {SimdLevel::Scalar, "scalar"},
+      {SimdLevel::AVX2, "avx2"},
+      {SimdLevel::AVX512, "avx512"}};
+  const vector<pair<BinaryKernel, string>> kernels = {
+      {[](uint64_t *dst, const uint64_t *a, const uint64_t *, size_t n) {
+         bitwise_not(dst, a, n);
+       },
+       "~  "},
+      {bitwise_and, "&  "},
+      {bitwise_or, "|  "},
+      {bitwise_xor, "^  "},
+      {bitwise_implies, "-> "},
+      {bitwise_equiv, "<->"}};
+
+  mt19937_64 mt(0);
+  for (size_t trace_length : trace_length_arr) {
+    size_t num_words = trace_length / 64;
+    vector<uint64_t> a(num_words), b(num_words), dst(num_words);
+    for (size_t w = 0; w < num_words; ++w) {
+      a[w] = mt();
+      b[w] = mt();
+    }
+    cout << "Running kernel benchmarks for trace length " << trace_length
+         << " (" << num_words * 8 / 1024 << " KiB per vector)\n";
+    for (const auto &[level, level_name] : levels) {
+      set_simd_level(level);
+      if (get_simd_level() != level) {
+        cout << "  [" << level_name << "] not supported by this CPU\n";
+        continue;
+      }
+      for (size_t k = 0; k < kernels.size(); ++k) {
+        int words_touched = (k == 0) ? 2 : 3;
+        double gbps = measure(kernels[k].first, dst.data(), a.data(),
+                              b.data(), num_words, words_touched);
+        cout << "  [" << level_name << "] " << kernels[k].second << " : "
+             << gbps << " GB/s\n";
+      }
+    }
+  }
+
+  // nested windows, fused against one window kernel after the other
+  struct Bounds {
+    size_t lb1, ub1, lb2, ub2;
+  };
+  // two narrow pairs (windows of up to 64 positions) and two wide ones
+  const vector<Bounds> bounds = {{0, 10, 0, 20},
+                                 {20, 60, 100, 130},
+                                 {0, 100, 0, 1000},
+                                 {5, 500, 0, 20000}};
+  for (size_t trace_length : trace_length_arr) {
+    BitVector p(trace_length), q(trace_length), r(trace_length);
+    for (size_t t = 0; t < trace_length; ++t) {
+      // mostly true, so the windows do not saturate
+      uint64_t x = mt();
+      p.set(t, (x & 7) != 0);
+      q.set(t, (x & 0x70) != 0);
+      r.set(t, (x & 0x300) == 0);
+    }
+    cout << "Running fused kernel benchmarks for trace length "
+         << trace_length << "\n";
+    for (const Bounds &b : bounds) {
+      string window1 = "[" + to_string(b.lb1) + "," + to_string(b.ub1) + "]";
+      string window2 = "[" + to_string(b.lb2) + "," + to_string(b.ub2) + "]";
+      double generic = measure_ms([&] {
+        window_any(window_all(p, b.lb2, b.ub2), b.lb1, b.ub1);
+      });
+      double fused =
+          measure_ms([&] { window_any_all(p, b.lb1, b.ub1, b.lb2, b.ub2); });
+      cout << "  F" << window1 << " G" << window2 << " p : generic " << generic
+           << "ms, fused " << fused << "ms\n";
+      generic = measure_ms([&] {
+        window_all(window_any(p, b.lb2, b.ub2), b.lb1, b.ub1);
+      });
+      fused =
+          measure_ms([&] { window_all_any(p, b.lb1, b.ub1, b.lb2, b.ub2); });
+      cout << "  G" << window1 << " F" << window2 << " p : generic " << generic
+           << "ms, fused " << fused << "ms\n";
+      generic = measure_ms([&] {
+        window_until(p, window_until(q, r, b.lb2, b.ub2), b.lb1, b.ub1);
+      });
+      fused = measure_ms(
+          [&] { window_until_until(p, q, r, b.lb1, b.ub1, b.lb2, b.ub2); });
+      cout << "  p U" << window1 << " (q U" << window2 << " r) : generic "
+           << generic << "ms, fused " << fused << "ms\n";
+    }
+  }
+
+  return 0;
+}
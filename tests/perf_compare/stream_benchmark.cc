@@ -0,0 +1,67 @@
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <random>
+
+#include "parser.hh"
+#include "stream.hh"
+
+using namespace std;
+using namespace libmltl;
+
+int main(int argc, char *argv[]) {
+  size_t trace_length = 20000000;
+  const int num_var = 4;
+  if (argc > 1) {
+    trace_length = stoul(argv[1]);
+  }
+  const vector<string> formulas_str = {
+      "G[0,10](p0 -> F[0,100](p1))",
+      "(p0 U[0,1000] p1) & G[0,5000](p2 | p3)",
+      "F[0,100000](p0 & p1 & p2 & p3)",
+  };
+
+  // written in the file format, so parsing is part of the measurement
+  filesystem::path path =
+      filesystem::temp_directory_path() /
+      ("libmltl-stream-benchmark-" + to_string(time(NULL)) + ".txt");
+  {
+    mt19937 mt(0);
+    ofstream file(path);
+    string line;
+    for (size_t t = 0; t < trace_length; ++t) {
+      string state = int_to_bin_str(mt(), num_var);
+      line.clear();
+      for (int id = 0; id < num_var; ++id) {
+        line += (id > 0 ? "," : "") + state.substr(id, 1);
+      }
+      file << line << '\n';
+    }
+  }
+  cout << "Streaming a trace of " << trace_length << " steps ("
+       << filesystem::file_size(path) / (1 << 20) << " MiB)\n";
+
+  for (const string &f : formulas_str) {
+    shared_ptr<ASTNode> formula = parse(f);
+    cout << "  " << formula->as_string() << "\n";
+    for (size_t window_size : {(size_t)1 << 16, default_stream_window}) {
+      ifstream file(path, ios::binary);
+      size_t count = 0;
+      StreamStats stats = evaluate_stream(
+          *formula, file,
+          [&](size_t, const BitVector &verdicts) { count += verdicts.count(); },
+          window_size);
+      cout << "    all steps, windows of " << window_size << ": "
+           << stats.steps_per_second() / 1e6 << "M steps/s (" << count
+           << " verdicts true)\n";
+    }
+    ifstream file(path, ios::binary);
+    StreamStats stats = evaluate_stream_final(
+        *formula, file, [](size_t, const BitVector &) {});
+    cout << "    final verdict: " << stats.steps << " steps read in "
+         << stats.seconds * 1e3 << "ms\n";
+  }
+  filesystem::remove(path);
+
+  return 0;
+}
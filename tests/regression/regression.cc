@@ -1,9 +1,26 @@
 #include <cmath>
+#include <filesystem>
 #include <fstream>
 #include <iostream>
+#include <random>
+#include <set>
+#include <sstream>
 #include <sys/time.h>
+#include <unistd.h>
 
+#include "batch.hh"
+#include "compiled.hh"
+#include "dsl.hh"
+#include "flat.hh"
+#include "intervals.hh"
+#include "jit.hh"
+#include "kernels.hh"
+#include "monitor.hh"
 #include "parser.hh"
+#include "prefix.hh"
+#include "satisfaction.hh"
+#include "stream.hh"
+#include "truth_table.hh"
 
 using namespace std;
 using namespace libmltl;
@@ -17,13 +34,13 @@ size_t max_trace_length(const vector<vector<string>> &traces) {
 }
 
 void generate_formulas(vector<shared_ptr<ASTNode>> &formulas, int vars,
-                       size_t max_ub) {
+                       size_t max_ub, ASTArena &arena) {
   size_t num_depth_minus_1 = formulas.size();
   if (num_depth_minus_1 == 0) {
-    // formulas.push_back(make_shared<Constant>(true));
-    // formulas.push_back(make_shared<Constant>(false));
+    // formulas.push_back(arena.make<Constant>(true));
+    // formulas.push_back(arena.make<Constant>(false));
     for (int i = 0; i < vars; ++i) {
-      formulas.emplace_back(make_shared<Variable>(i));
+      formulas.emplace_back(arena.make<Variable>(i));
     }
     return;
   }
@@ -32,62 +49,1013 @@ void generate_formulas(vector<shared_ptr<ASTNode>> &formulas, int vars,
   for (size_t i = 0; i < num_depth_minus_1; ++i) {
     if (formulas[i]->get_type() != ASTNode::Type::Negation) {
       // no need to double negate
-      formulas.emplace_back(make_shared<Negation>(formulas[i]));
+      formulas.emplace_back(arena.make<Negation>(formulas[i]));
     }
     for (size_t lb = 0; lb <= max_ub; ++lb) {
       for (size_t ub = lb; ub <= max_ub; ++ub) {
         formulas.emplace_back(
-            make_shared<Finally>(formulas[i], lb, ub));
+            arena.make<Finally>(formulas[i], lb, ub));
         formulas.emplace_back(
-            make_shared<Globally>(formulas[i], lb, ub));
+            arena.make<Globally>(formulas[i], lb, ub));
       }
     }
-    formulas.emplace_back(make_shared<Finally>(formulas[i], 0, 2));
+    formulas.emplace_back(arena.make<Finally>(formulas[i], 0, 2));
     formulas.emplace_back(
-        make_shared<Globally>(formulas[i], 0, 2));
+        arena.make<Globally>(formulas[i], 0, 2));
   }
 
   // create every possible binary operation
   for (size_t i = 0; i < num_depth_minus_1; ++i) {
     size_t op = num_depth_minus_1 - 1 - i;
     formulas.emplace_back(
-        make_shared<And>(formulas[i], formulas[op]));
+        arena.make<And>(formulas[i], formulas[op]));
     // formulas.emplace_back(
-    //     make_shared<Xor>(formulas[i],
+    //     arena.make<Xor>(formulas[i],
     //     formulas[j]));
     formulas.emplace_back(
-        make_shared<Or>(formulas[i], formulas[op]));
-    // formulas.emplace_back(make_shared<Implies>(formulas[i],
+        arena.make<Or>(formulas[i], formulas[op]));
+    // formulas.emplace_back(arena.make<Implies>(formulas[i],
     //                                            formulas[j]));
-    // formulas.emplace_back(make_shared<Equiv>(formulas[i],
+    // formulas.emplace_back(arena.make<Equiv>(formulas[i],
     //                                          formulas[j]));
     for (size_t lb = 0; lb <= max_ub; ++lb) {
       for (size_t ub = lb; ub <= max_ub; ++ub) {
-        formulas.emplace_back(make_shared<Until>(
+        formulas.emplace_back(arena.make<Until>(
             formulas[i], formulas[op], lb, ub));
-        formulas.emplace_back(make_shared<Release>(
+        formulas.emplace_back(arena.make<Release>(
             formulas[i], formulas[op], lb, ub));
       }
     }
-    // formulas.emplace_back(make_shared<Until>(formulas[i],
+    // formulas.emplace_back(arena.make<Until>(formulas[i],
     //                                          formulas[op], 0,
     //                                          2));
-    // formulas.emplace_back(make_shared<Release>(
+    // formulas.emplace_back(arena.make<Release>(
     //     formulas[i], formulas[op], 0, 2));
   }
 
   return;
 }
 
+/* Generates all formulas up to max_depth into arena, which holds the nodes
+ * for as long as the formulas are used.
+ */
 void generate_formulas(vector<shared_ptr<ASTNode>> &formulas, int max_depth,
-                       int max_vars, size_t max_ub) {
+                       int max_vars, size_t max_ub, ASTArena &arena) {
   for (int depth = 0; depth <= max_depth; ++depth) {
     cout << "generating formulas of depth " << depth << "\n";
-    generate_formulas(formulas, max_vars, max_ub);
+    generate_formulas(formulas, max_vars, max_ub, arena);
   }
   return;
 }
 
+/* Compares the results of an alternative evaluation path against the results
+ * of ASTNode::evaluate. Prints the first counter example for each formula that
+ * differs.
+ */
+bool compare_results(const string &name,
+                     const vector<shared_ptr<ASTNode>> &formulas,
+                     const vector<vector<string>> &traces,
+                     const vector<vector<bool>> &expected,
+                     const vector<vector<bool>> &actual) {
+  bool valid = true;
+  for (size_t i = 0; i < formulas.size(); ++i) {
+    for (size_t j = 0; j < traces.size(); ++j) {
+      if (expected[i][j] != actual[i][j]) {
+        valid = false;
+        cout << "FAIL (" << name << "): " << formulas[i]->as_string()
+             << "\n      ";
+        for (const string &state : traces[j]) {
+          cout << state << " ";
+        }
+        cout << "\n";
+        break;
+      }
+    }
+  }
+  cout << (valid ? "PASS (" : "FAIL (") << name << ")\n";
+  return valid;
+}
+
+vector<vector<bool>> matrix_rows(const vector<BitVector> &matrix) {
+  vector<vector<bool>> rows;
+  for (const BitVector &row : matrix) {
+    rows.emplace_back();
+    for (size_t j = 0; j < row.size(); ++j) {
+      rows.back().push_back(row[j]);
+    }
+  }
+  return rows;
+}
+
+/* Every task of a loop must run exactly once, and an exception thrown by a
+ * task must reach the caller.
+ */
+bool check_thread_pool() {
+  bool valid = true;
+  ThreadPool pool(4);
+  for (size_t num_tasks : {0, 1, 3, 1000}) {
+    vector<atomic<int>> runs(num_tasks);
+    pool.run(num_tasks, [&](size_t t) { ++runs[t]; });
+    for (size_t t = 0; t < num_tasks; ++t) {
+      if (runs[t] != 1) {
+        cout << "FAIL (thread pool): task " << t << " of " << num_tasks
+             << " ran " << runs[t] << " times\n";
+        valid = false;
+        break;
+      }
+    }
+  }
+  try {
+    pool.run(1000, [](size_t t) {
+      if (t == 500) {
+        throw runtime_error("task failed");
+      }
+    });
+    cout << "FAIL (thread pool): exception was not rethrown\n";
+    valid = false;
+  } catch (const runtime_error &) {
+  }
+  // a task running a loop on its own pool would wait for itself
+  try {
+    pool.run(8, [&](size_t) { pool.run(1, [](size_t) {}); });
+    cout << "FAIL (thread pool): nested run was not rejected\n";
+    valid = false;
+  } catch (const logic_error &) {
+  }
+  // loops started from several threads at once run one after the other
+  vector<atomic<int>> runs(1000);
+  vector<thread> callers;
+  for (int i = 0; i < 3; ++i) {
+    callers.emplace_back([&] {
+      for (int k = 0; k < 10; ++k) {
+        pool.run(runs.size(), [&](size_t t) { ++runs[t]; });
+      }
+    });
+  }
+  for (thread &caller : callers) {
+    caller.join();
+  }
+  for (size_t t = 0; t < runs.size(); ++t) {
+    if (runs[t] != 30) {
+      cout << "FAIL (thread pool): concurrent runs ran task " << t << " "
+           << runs[t] << " times\n";
+      valid = false;
+      break;
+    }
+  }
+  cout << (valid ? "PASS (" : "FAIL (") << "thread pool)\n";
+  return valid;
+}
+
+/* Checks an engine that computes satisfaction vectors over every stride-th
+ * trace: bit i of eval_all(formula, j) must equal
+ * formula->evaluate_subt(traces[j], i, traces[j].size()) for every i.
+ */
+template <typename EvalAll>
+bool check_all_positions(const string &name,
+                         const vector<shared_ptr<ASTNode>> &formulas,
+                         const vector<vector<string>> &traces, size_t stride,
+                         EvalAll eval_all) {
+  struct timeval start, end;
+  gettimeofday(&start, NULL); // start timer
+  bool valid = true;
+  for (size_t i = 0; i < formulas.size(); ++i) {
+    for (size_t j = 0; j < traces.size(); j += stride) {
+      BitVector actual = eval_all(*formulas[i], j);
+      size_t k = 0;
+      for (; k < traces[j].size(); ++k) {
+        if (actual.size() != traces[j].size() ||
+            actual[k] !=
+                formulas[i]->evaluate_subt(traces[j], k, traces[j].size())) {
+          break;
+        }
+      }
+      if (k != traces[j].size()) {
+        valid = false;
+        cout << "FAIL (" << name << "): " << formulas[i]->as_string()
+             << " at time step " << k << "\n      ";
+        for (const string &state : traces[j]) {
+          cout << state << " ";
+        }
+        cout << "\n";
+        break;
+      }
+    }
+  }
+  gettimeofday(&end, NULL); // stop timer
+  double time_taken = end.tv_sec + end.tv_usec / 1e6 - start.tv_sec -
+                      start.tv_usec / 1e6; // in seconds
+  cout << name << " check took: " << time_taken << "s\n";
+  cout << (valid ? "PASS (" : "FAIL (") << name << ")\n";
+  return valid;
+}
+
+/* Formulas with wide windows, checked over long random traces so that the
+ * word-level kernels cross word boundaries.
+ */
+const vector<string> long_trace_formulas = {
+    "F[0,100](p0)",         "G[5,200](p1)",          "G[0,70](p0|p2)",
+    "F[63,64](p2)",         "F[10,1000](p2)",        "G[0,1500](p0|~p0)",
+    "G[1,129](~p2)",        "(p0)U[3,150](p2)",      "(p1)R[0,90](p0)",
+    "F[0,40]G[0,80](p0)",   "G[1,65]F[2,130](p1)",   "F[2000,2500](p1)",
+    "(p0&p1)U[0,64](~p0)",  "(~p2)R[64,300](p0)",    "G[0,3000](p0)",
+    "(p0)U[0,1000](p2)",    "(p1)R[10,1000](p0)",
+    "(p0)U[0,1000]((p1)U[0,500](p2))",
+};
+
+vector<vector<string>> generate_long_traces(size_t num_traces,
+                                            size_t trace_length) {
+  // p0 is almost always true, p1 is random and p2 is rarely true
+  mt19937 mt(0);
+  vector<vector<string>> traces(num_traces);
+  for (auto &trace : traces) {
+    for (size_t i = 0; i < trace_length; ++i) {
+      string state = "000";
+      state[0] = (mt() % 512 != 0) ? '1' : '0';
+      state[1] = (mt() % 2 != 0) ? '1' : '0';
+      state[2] = (mt() % 128 == 0) ? '1' : '0';
+      trace.push_back(state);
+    }
+  }
+  return traces;
+}
+
+/* Checks that evaluating chunks of each trace in parallel gives exactly the
+ * satisfaction vector of the sequential evaluate_all.
+ */
+bool check_chunked(const string &name,
+                   const vector<shared_ptr<ASTNode>> &formulas,
+                   const vector<Trace> &traces,
+                   const vector<size_t> &chunk_sizes) {
+  ThreadPool pool(3);
+  for (const auto &formula : formulas) {
+    for (const Trace &trace : traces) {
+      BitVector expected = evaluate_all(*formula, trace);
+      for (size_t chunk_size : chunk_sizes) {
+        if (evaluate_all(*formula, trace, pool, chunk_size) != expected) {
+          cout << "FAIL (" << name << "): " << formula->as_string()
+               << " with chunks of " << chunk_size << "\n";
+          return false;
+        }
+      }
+    }
+  }
+  cout << "PASS (" << name << ")\n";
+  return true;
+}
+
+/* Checks that streaming each trace in windows gives exactly the satisfaction
+ * vector of evaluate_all, and that the final verdict only reads the states
+ * that decide it. The traces are written in the file format, the odd ones with
+ * CRLF line ends and without a newline after the last state.
+ */
+bool check_stream(const string &name,
+                  const vector<shared_ptr<ASTNode>> &formulas,
+                  const vector<vector<string>> &traces,
+                  const vector<size_t> &window_sizes) {
+  for (size_t j = 0; j < traces.size(); ++j) {
+    string text;
+    for (size_t t = 0; t < traces[j].size(); ++t) {
+      for (size_t id = 0; id < traces[j][t].size(); ++id) {
+        text += (id > 0 ? "," : "") + traces[j][t].substr(id, 1);
+      }
+      if (j % 2 == 0) {
+        text += "\n";
+      } else if (t + 1 < traces[j].size()) {
+        text += "\r\n";
+      }
+    }
+    for (const auto &formula : formulas) {
+      BitVector expected = evaluate_all(*formula, traces[j]);
+      for (size_t window_size : window_sizes) {
+        istringstream in(text);
+        BitVector actual;
+        StreamStats stats = evaluate_stream(
+            *formula, in,
+            [&](size_t begin, const BitVector &verdicts) {
+              if (begin != actual.size()) {
+                cout << "FAIL (" << name << "): verdicts from " << begin
+                     << " after " << actual.size() << "\n";
+              }
+              for (size_t i = 0; i < verdicts.size(); ++i) {
+                actual.push_back(verdicts[i]);
+              }
+            },
+            window_size);
+        if (actual != expected || stats.steps != traces[j].size()) {
+          cout << "FAIL (" << name << "): " << formula->as_string()
+               << " in windows of " << window_size << "\n";
+          return false;
+        }
+      }
+      istringstream in(text);
+      bool verdict = !formula->evaluate(traces[j]);
+      StreamStats stats = evaluate_stream_final(
+          *formula, in,
+          [&](size_t, const BitVector &verdicts) { verdict = verdicts[0]; });
+      if (verdict != formula->evaluate(traces[j]) ||
+          stats.steps > evaluation_reach(*formula)) {
+        cout << "FAIL (" << name << "): final verdict of "
+             << formula->as_string() << "\n";
+        return false;
+      }
+    }
+  }
+  cout << "PASS (" << name << ")\n";
+  return true;
+}
+
+/* Checks the interval engine on a long trace of slowly changing signals
+ * against evaluate_all on its dense form.
+ */
+bool check_slow_signals(const vector<shared_ptr<ASTNode>> &formulas,
+                        size_t trace_length) {
+  mt19937 mt(0);
+  vector<IntervalSet> columns(3);
+  for (IntervalSet &column : columns) {
+    // runs of 1 to 100000 time steps, alternating between true and false
+    bool value = mt() & 1;
+    for (size_t t = 0; t < trace_length; value = !value) {
+      size_t end = min(trace_length, t + 1 + mt() % 100000);
+      if (value) {
+        column.push_back(t, end);
+      }
+      t = end;
+    }
+  }
+  IntervalTrace intervals(trace_length, columns);
+  Trace dense = intervals.to_trace();
+  double dense_time = 0, interval_time = 0;
+  struct timeval start, end;
+  for (const auto &formula : formulas) {
+    gettimeofday(&start, NULL); // start timer
+    BitVector expected = evaluate_all(*formula, dense);
+    gettimeofday(&end, NULL); // stop timer
+    dense_time += end.tv_sec + end.tv_usec / 1e6 - start.tv_sec -
+                  start.tv_usec / 1e6;
+    gettimeofday(&start, NULL); // start timer
+    IntervalSet actual = evaluate_intervals(*formula, intervals);
+    gettimeofday(&end, NULL); // stop timer
+    interval_time += end.tv_sec + end.tv_usec / 1e6 - start.tv_sec -
+                     start.tv_usec / 1e6;
+    if (IntervalSet(expected) != actual) {
+      cout << "FAIL (intervals, slow signals): " << formula->as_string()
+           << "\n";
+      return false;
+    }
+  }
+  cout << "slow signals (" << trace_length
+       << " steps): evaluate_all took " << dense_time
+       << "s, intervals took " << interval_time << "s\n";
+  cout << "PASS (intervals, slow signals)\n";
+  return true;
+}
+
+/* Checks the dictionary encoding with ids of every width: random traces over
+ * num_vars variables have about min(length, 2^num_vars) distinct states.
+ */
+bool check_dictionary_widths(const vector<shared_ptr<ASTNode>> &formulas) {
+  mt19937 mt(0);
+  for (auto [num_vars, length, width] :
+       {make_tuple(4, 100000, 1), make_tuple(12, 100000, 2),
+        make_tuple(20, 200000, 4)}) {
+    vector<string> states(length);
+    for (string &state : states) {
+      state = int_to_bin_str(mt(), num_vars);
+    }
+    DictionaryTrace dictionary(states);
+    Trace packed(states);
+    if (dictionary.id_width() != (size_t)width ||
+        dictionary.as_strings() != states) {
+      cout << "FAIL (dictionary trace): " << num_vars << " variables, "
+           << dictionary.num_states() << " states\n";
+      return false;
+    }
+    for (const auto &formula : formulas) {
+      if (evaluate_all(*formula, dictionary) !=
+          evaluate_all(*formula, packed)) {
+        cout << "FAIL (dictionary trace): " << formula->as_string() << " on "
+             << num_vars << " variables\n";
+        return false;
+      }
+    }
+  }
+  // characters other than '1' read as 0, so these are all one state
+  DictionaryTrace mixed(vector<string>{"1x", "10", "1 ", "10", "1", "100"});
+  if (mixed.num_states() != 1 || mixed.id_width() != 1 ||
+      mixed.as_strings() != vector<string>(6, "10")) {
+    cout << "FAIL (dictionary trace): " << mixed.num_states()
+         << " states for one normalised state\n";
+    return false;
+  }
+  cout << "PASS (dictionary trace widths)\n";
+  return true;
+}
+
+/* Checks that formulas parsed into and copied into an arena equal those on
+ * the heap, and evaluate the same, also after the arena is cleared and
+ * reused.
+ */
+bool check_arena(const vector<shared_ptr<ASTNode>> &formulas,
+                 const Trace &trace) {
+  ASTArena arena;
+  size_t num_nodes = 0;
+  for (const auto &formula : formulas) {
+    num_nodes += formula->size();
+  }
+  for (int round = 0; round < 2; ++round) {
+    for (const auto &formula : formulas) {
+      shared_ptr<ASTNode> parsed = parse(formula->as_string(), arena);
+      shared_ptr<ASTNode> copy = formula->deep_copy(arena);
+      if (*parsed != *parse(formula->as_string()) || *copy != *formula ||
+          evaluate_all(*parsed, trace) != evaluate_all(*formula, trace)) {
+        cout << "FAIL (ast arena): " << formula->as_string() << "\n";
+        return false;
+      }
+    }
+    // parsed and copied
+    if (arena.size() != 2 * num_nodes) {
+      cout << "FAIL (ast arena): " << arena.size() << " nodes\n";
+      return false;
+    }
+    arena.clear();
+  }
+  cout << "PASS (ast arena)\n";
+  return true;
+}
+
+/* Checks that unique formulas equal the formulas they are made from, hand
+ * out handles without a reference count, and evaluate the same in a batch
+ * shared by several threads.
+ */
+bool check_unique_formulas(const vector<shared_ptr<ASTNode>> &formulas,
+                           const vector<Trace> &traces) {
+  vector<shared_ptr<ASTNode>> sample, handles;
+  vector<UniqueFormula> owners;
+  for (size_t i = 0; i < formulas.size(); i += 16) {
+    const ASTNode &formula = *formulas[i];
+    UniqueFormula copy(formula), parsed(formula.as_string());
+    if (copy.get() != formula || *parsed != formula ||
+        copy.handle().use_count() != 0) {
+      cout << "FAIL (unique formula): " << formula.as_string() << "\n";
+      return false;
+    }
+    sample.push_back(formulas[i]);
+    // the nodes stay where they are when the owner moves
+    owners.push_back(std::move(copy));
+    handles.push_back(owners.back().handle());
+  }
+  if (evaluate_batch(handles, traces, 4) != evaluate_batch(sample, traces, 1)) {
+    cout << "FAIL (unique formula): batch evaluation differs\n";
+    return false;
+  }
+  cout << "PASS (unique formula)\n";
+  return true;
+}
+
+/* Checks that flat formulas convert back to the formulas they are made from,
+ * and that their analyses and comparisons agree with those of the trees.
+ */
+bool check_flat_formulas(const vector<shared_ptr<ASTNode>> &formulas) {
+  const ASTNode::Type types[] = {
+      ASTNode::Type::Constant, ASTNode::Type::Variable,
+      ASTNode::Type::Negation, ASTNode::Type::And,
+      ASTNode::Type::Xor,      ASTNode::Type::Or,
+      ASTNode::Type::Implies,  ASTNode::Type::Equiv,
+      ASTNode::Type::Finally,  ASTNode::Type::Globally,
+      ASTNode::Type::Until,    ASTNode::Type::Release};
+  ASTArena arena;
+  for (size_t i = 0; i < formulas.size(); ++i) {
+    const ASTNode &formula = *formulas[i];
+    const ASTNode &other = *formulas[(i * 7 + 1) % formulas.size()];
+    FlatFormula flat(formula);
+    bool counts = true;
+    for (ASTNode::Type type : types) {
+      counts = counts && flat.count(type) == formula.count(type);
+    }
+    if (*flat.to_ast() != formula || *flat.to_ast(arena) != formula ||
+        flat.size() != formula.size() || flat.depth() != formula.depth() ||
+        flat.future_reach() != formula.future_reach() || !counts ||
+        (flat == FlatFormula(other)) != (formula == other) ||
+        flat != FlatFormula(*formula.deep_copy())) {
+      cout << "FAIL (flat formula): " << formula.as_string() << "\n";
+      return false;
+    }
+  }
+  cout << "PASS (flat formula)\n";
+  return true;
+}
+
+/* Checks that the setters of a binary operator replace the operand they name
+ * and leave the other one alone.
+ */
+bool check_binary_setters() {
+  auto formula = make_shared<Until>(make_shared<Variable>(0),
+                                    make_shared<Variable>(1), 0, 3);
+  formula->set_right(make_shared<Variable>(2));
+  formula->set_left(make_shared<Negation>(make_shared<Variable>(3)));
+  if (formula->get_right() != Variable(2) ||
+      formula->get_left() != Negation(make_shared<Variable>(3)) ||
+      *parse(formula->as_string()) != *formula) {
+    cout << "FAIL (binary setters): " << formula->as_string() << "\n";
+    return false;
+  }
+  cout << "PASS (binary setters)\n";
+  return true;
+}
+
+/* Checks that a factory interns equal formulas, however they are made, to
+ * the same node, one per distinct formula, and that structural hashes follow
+ * changes to a formula.
+ */
+bool check_factory(const vector<shared_ptr<ASTNode>> &formulas) {
+  FormulaFactory factory;
+  set<const ASTNode *> interned;
+  for (const auto &formula : formulas) {
+    shared_ptr<ASTNode> node = factory.intern(*formula);
+    shared_ptr<ASTNode> copy = formula->deep_copy();
+    if (factory.intern(*copy) != node ||
+        parse(formula->as_string(), factory) != node || *node != *formula ||
+        node->hash() != formula->hash() ||
+        hash<ASTNode>()(*copy) != formula->hash()) {
+      cout << "FAIL (formula factory): " << formula->as_string() << "\n";
+      return false;
+    }
+    interned.insert(node.get());
+  }
+  // as many interned formulas as distinct ones, in the order of operator<
+  vector<shared_ptr<ASTNode>> sorted = formulas;
+  sort(sorted.begin(), sorted.end(),
+       [](const auto &a, const auto &b) { return *a < *b; });
+  size_t num_distinct = unique(sorted.begin(), sorted.end(),
+                               [](const auto &a, const auto &b) {
+                                 return *a == *b;
+                               }) -
+                        sorted.begin();
+  if (interned.size() != num_distinct) {
+    cout << "FAIL (formula factory): " << interned.size()
+         << " interned formulas, expected " << num_distinct << "\n";
+    return false;
+  }
+
+  shared_ptr<ASTNode> formula = parse("(p0)U[0,2](p1)");
+  auto until = static_pointer_cast<Until>(formula);
+  auto globally = static_pointer_cast<Globally>(parse("G[1,3](p1&p2)"));
+  until->set_right(globally);
+  // changes below the root need a rehash
+  globally->set_upper_bound(4);
+  formula->rehash();
+  if (formula->hash() != parse("(p0)U[0,2](G[1,4](p1&p2))")->hash() ||
+      formula->hash() != factory.intern(*formula)->hash()) {
+    cout << "FAIL (formula factory): hash after changes\n";
+    return false;
+  }
+  cout << "PASS (formula factory)\n";
+  return true;
+}
+
+/* Orders formulas like ASTNode::compare, through the public accessors only:
+ * by type, then operands from left to right, then value, id or bounds.
+ */
+int reference_compare(const ASTNode &a, const ASTNode &b) {
+  auto sign = [](auto x, auto y) { return (x > y) - (x < y); };
+  if (a.get_type() != b.get_type()) {
+    return sign(a.get_type(), b.get_type());
+  }
+  switch (a.get_type()) {
+  case ASTNode::Type::Constant:
+    return sign(static_cast<const Constant &>(a).get_value(),
+                static_cast<const Constant &>(b).get_value());
+  case ASTNode::Type::Variable:
+    return sign(static_cast<const Variable &>(a).get_id(),
+                static_cast<const Variable &>(b).get_id());
+  default:
+    break;
+  }
+  int result = 0;
+  size_t a_lb = 0, a_ub = 0, b_lb = 0, b_ub = 0;
+  if (a.is_unary_op()) {
+    result = reference_compare(static_cast<const UnaryOp &>(a).get_operand(),
+                               static_cast<const UnaryOp &>(b).get_operand());
+  } else {
+    const BinaryOp &x = static_cast<const BinaryOp &>(a);
+    const BinaryOp &y = static_cast<const BinaryOp &>(b);
+    result = reference_compare(x.get_left(), y.get_left());
+    if (result == 0) {
+      result = reference_compare(x.get_right(), y.get_right());
+    }
+  }
+  if (a.get_type() == ASTNode::Type::Finally ||
+      a.get_type() == ASTNode::Type::Globally) {
+    const UnaryTempOp &x = static_cast<const UnaryTempOp &>(a);
+    const UnaryTempOp &y = static_cast<const UnaryTempOp &>(b);
+    a_lb = x.get_lower_bound(), a_ub = x.get_upper_bound();
+    b_lb = y.get_lower_bound(), b_ub = y.get_upper_bound();
+  } else if (a.is_temporal_op()) {
+    const BinaryTempOp &x = static_cast<const BinaryTempOp &>(a);
+    const BinaryTempOp &y = static_cast<const BinaryTempOp &>(b);
+    a_lb = x.get_lower_bound(), a_ub = x.get_upper_bound();
+    b_lb = y.get_lower_bound(), b_ub = y.get_upper_bound();
+  }
+  if (result == 0) {
+    result = (a_lb != b_lb) ? sign(a_lb, b_lb) : sign(a_ub, b_ub);
+  }
+  return result;
+}
+
+/* Checks that compare and every comparison operator built on it agree with
+ * the reference order, for pairs of formulas and copies of them.
+ */
+bool check_compare(const vector<shared_ptr<ASTNode>> &formulas) {
+  for (size_t i = 0; i < formulas.size(); ++i) {
+    const ASTNode &a = *formulas[i];
+    shared_ptr<ASTNode> copy = a.deep_copy();
+    vector<const ASTNode *> others = {
+        formulas[(i * 7 + 1) % formulas.size()].get(),
+        formulas[(i + 1) % formulas.size()].get(), copy.get(), &a};
+    for (const ASTNode *b : others) {
+      int expected = reference_compare(a, *b);
+      int result = a.compare(*b), reverse = b->compare(a);
+      if ((result > 0) - (result < 0) != expected ||
+          (reverse > 0) - (reverse < 0) != -expected ||
+          (a == *b) != (expected == 0) || (a != *b) != (expected != 0) ||
+          (a < *b) != (expected < 0) || (a <= *b) != (expected <= 0) ||
+          (a > *b) != (expected > 0) || (a >= *b) != (expected >= 0)) {
+        cout << "FAIL (compare): " << a.as_string() << " vs "
+             << b->as_string() << "\n";
+        return false;
+      }
+    }
+  }
+  cout << "PASS (compare)\n";
+  return true;
+}
+
+/* Checks that every supported instruction set gives the same results as the
+ * scalar propositional kernels.
+ */
+bool check_simd_levels() {
+  mt19937 mt(0);
+  size_t n = 64 * 37 + 13; // not a multiple of any vector width
+  BitVector a(n), b(n);
+  for (size_t i = 0; i < n; ++i) {
+    a.set(i, mt() & 1);
+    b.set(i, mt() & 1);
+  }
+  auto apply_all = [&]() {
+    return vector<BitVector>{bitwise_not(a),     bitwise_and(a, b),
+                             bitwise_or(a, b),   bitwise_xor(a, b),
+                             bitwise_implies(a, b), bitwise_equiv(a, b)};
+  };
+  SimdLevel default_level = get_simd_level();
+  set_simd_level(SimdLevel::Scalar);
+  vector<BitVector> expected = apply_all();
+  bool valid = true;
+  for (SimdLevel level : {SimdLevel::AVX2, SimdLevel::AVX512}) {
+    set_simd_level(level);
+    if (get_simd_level() == level && apply_all() != expected) {
+      cout << "FAIL (simd kernels): level " << (int)level << "\n";
+      valid = false;
+    }
+  }
+  set_simd_level(default_level);
+  cout << (valid ? "PASS (simd kernels)\n" : "FAIL (simd kernels)\n");
+  return valid;
+}
+
+/* Checks the fused kernels for nested windows against the window kernels
+ * applied one after the other, for narrow and wide, empty and out of range
+ * windows on vectors that end inside a word and span several tiles.
+ */
+bool check_fused_kernels() {
+  mt19937 mt(0);
+  for (size_t n : {0, 1, 63, 64, 1000, 64 * 2048 * 3 + 17}) {
+    BitVector p(n), q(n), r(n);
+    for (size_t i = 0; i < n; ++i) {
+      // runs of set bits, so that windows of either kind vary
+      p.set(i, (mt() & 7) != 0);
+      q.set(i, (mt() & 3) != 0);
+      r.set(i, (mt() & 31) == 0);
+    }
+    vector<pair<size_t, size_t>> windows = {
+        {0, 0}, {0, 5}, {3, 63}, {70, 100}, {5, 4}, {10, 2}, {0, 300},
+        {100, 5000}, {0, 200000}, {n, n + 3}};
+    for (auto [lb1, ub1] : windows) {
+      for (auto [lb2, ub2] : windows) {
+        if (window_any_all(p, lb1, ub1, lb2, ub2) !=
+                window_any(window_all(p, lb2, ub2), lb1, ub1) ||
+            window_all_any(p, lb1, ub1, lb2, ub2) !=
+                window_all(window_any(p, lb2, ub2), lb1, ub1) ||
+            window_until_until(p, q, r, lb1, ub1, lb2, ub2) !=
+                window_until(p, window_until(q, r, lb2, ub2), lb1, ub1)) {
+          cout << "FAIL (fused kernels): n = " << n << ", [" << lb1 << ","
+               << ub1 << "] over [" << lb2 << "," << ub2 << "]\n";
+          return false;
+        }
+      }
+    }
+  }
+  cout << "PASS (fused kernels)\n";
+  return true;
+}
+
+/* Checks the three-valued verdicts of every formula on the prefixes of the
+ * given lengths of every stride-th trace: a decided verdict must be the
+ * verdict of every longer prefix (each one is a continuation), stay decided,
+ * and be decided from evaluation_reach states on. decision_length must find
+ * the shortest deciding prefix.
+ */
+bool check_prefix(const string &name,
+                  const vector<shared_ptr<ASTNode>> &formulas,
+                  const vector<vector<string>> &traces, size_t stride,
+                  const vector<size_t> &lengths) {
+  struct timeval start, end;
+  gettimeofday(&start, NULL); // start timer
+  bool valid = true;
+  for (size_t j = 0; j < traces.size() && valid; j += stride) {
+    vector<Trace> prefixes;
+    for (size_t length : lengths) {
+      length = min(length, traces[j].size());
+      prefixes.emplace_back(vector<string>(traces[j].begin(),
+                                           traces[j].begin() + length));
+    }
+    Trace trace(traces[j]);
+    for (size_t i = 0; i < formulas.size(); ++i) {
+      const ASTNode &formula = *formulas[i];
+      size_t reach = evaluation_reach(formula);
+      vector<Verdict> verdicts;
+      vector<bool> expected;
+      for (const Trace &prefix : prefixes) {
+        verdicts.push_back(evaluate_prefix(formula, prefix));
+        expected.push_back(formula.evaluate(prefix));
+      }
+      size_t decision = decision_length(formula, trace);
+      for (size_t m = 0; m < prefixes.size() && valid; ++m) {
+        size_t length = prefixes[m].size();
+        if (verdicts[m] == Verdict::Unknown) {
+          valid = length < reach && (m == 0 || verdicts[m - 1] ==
+                                                   Verdict::Unknown);
+          valid = valid && (decision == (size_t)-1 || decision > length);
+          continue;
+        }
+        valid = decision <= length;
+        for (size_t k = m; k < prefixes.size(); ++k) {
+          valid = valid && (verdicts[m] == Verdict::True) == expected[k];
+        }
+      }
+      if (decision != (size_t)-1 && valid) {
+        Trace shortest(vector<string>(traces[j].begin(),
+                                      traces[j].begin() + decision));
+        valid = evaluate_prefix(formula, shortest) != Verdict::Unknown;
+        if (decision > 0) {
+          Trace shorter(vector<string>(traces[j].begin(),
+                                       traces[j].begin() + decision - 1));
+          valid = valid && evaluate_prefix(formula, shorter) ==
+                               Verdict::Unknown;
+        }
+      }
+      if (!valid) {
+        cout << "FAIL (" << name << "): " << formula.as_string()
+             << "\n      ";
+        for (const string &state : traces[j]) {
+          cout << state << " ";
+        }
+        cout << "\n";
+        break;
+      }
+    }
+  }
+  gettimeofday(&end, NULL); // stop timer
+  double time_taken = end.tv_sec + end.tv_usec / 1e6 - start.tv_sec -
+                      start.tv_usec / 1e6; // in seconds
+  cout << name << " check took: " << time_taken << "s\n";
+  cout << (valid ? "PASS (" : "FAIL (") << name << ")\n";
+  return valid;
+}
+
+/* Streams trace through monitor from the start and returns the verdicts at
+ * every time step, the final ones followed by the truncated ones.
+ */
+BitVector monitor_verdicts(Monitor &monitor, const vector<string> &trace) {
+  monitor.reset();
+  BitVector verdicts;
+  for (const string &state : trace) {
+    if (optional<bool> verdict = monitor.push(state)) {
+      verdicts.push_back(*verdict);
+    }
+  }
+  if (verdicts.size() != monitor.num_verdicts()) {
+    return BitVector();
+  }
+  BitVector truncated = monitor.truncated_verdicts();
+  for (size_t t = 0; t < truncated.size(); ++t) {
+    verdicts.push_back(truncated[t]);
+  }
+  return verdicts;
+}
+
+/* Checks that the monitor of every formula finalizes its verdicts after
+ * max(1, evaluation_reach) - 1 states.
+ */
+bool check_monitor_delay(const vector<shared_ptr<ASTNode>> &formulas) {
+  for (const auto &formula : formulas) {
+    if (Monitor(*formula).delay() + 1 !=
+        max((size_t)1, evaluation_reach(*formula))) {
+      cout << "FAIL (monitor delay): " << formula->as_string() << "\n";
+      return false;
+    }
+  }
+  return true;
+}
+
+/* Random formula without temporal operators of the given depth over
+ * variables p0 to p(num_vars - 1).
+ */
+shared_ptr<ASTNode> random_propositional(mt19937 &mt, int num_vars,
+                                         int depth) {
+  if (depth == 0) {
+    return make_shared<Variable>(mt() % num_vars);
+  }
+  shared_ptr<ASTNode> left = random_propositional(mt, num_vars, depth - 1);
+  int op = mt() % 6;
+  if (op == 0) {
+    return make_shared<Negation>(left);
+  }
+  shared_ptr<ASTNode> right = random_propositional(mt, num_vars, depth - 1);
+  switch (op) {
+  case 1:
+    return make_shared<And>(left, right);
+  case 2:
+    return make_shared<Xor>(left, right);
+  case 3:
+    return make_shared<Or>(left, right);
+  case 4:
+    return make_shared<Implies>(left, right);
+  default:
+    return make_shared<Equiv>(left, right);
+  }
+}
+
+/* Checks truth tables against evaluate on random states, and the monitor,
+ * which tabulates propositional subformulas, on formulas with large
+ * propositional cores.
+ */
+bool check_truth_tables() {
+  mt19937 mt(0);
+  for (int num_vars : {1, 5, 16}) {
+    for (int i = 0; i < 20; ++i) {
+      shared_ptr<ASTNode> formula = random_propositional(mt, num_vars, 5);
+      TruthTable table(*formula);
+      for (int j = 0; j < 1000; ++j) {
+        // too short or too long states, as Monitor may pass them
+        string state = int_to_bin_str(mt(), mt() % (num_vars + 2));
+        Trace trace(vector<string>{state});
+        if (table.evaluate(state, state.size()) != formula->evaluate(trace)) {
+          cout << "FAIL (truth table): " << formula->as_string() << " at "
+               << state << "\n";
+          return false;
+        }
+      }
+    }
+  }
+  vector<string> cores = {"(p0 & ~p3) | (p2 ^ p5) -> p7",
+                          "(p0 | p1 | p2 | p3) & (p4 <-> ~p5) & (p6 -> p7)",
+                          "~(p0 & p1 & p2 & p3 & p4 & p5 & p6 & p7)"};
+  vector<string> trace(100000);
+  for (string &state : trace) {
+    state = int_to_bin_str(mt(), 8);
+  }
+  Trace packed(trace);
+  for (const string &core : cores) {
+    for (const string &f : {"G[0,10](" + core + ")",
+                            "(" + core + ") U[2,50] p1 & F[0,5](" + core +
+                                ")"}) {
+      shared_ptr<ASTNode> formula = parse(f);
+      Monitor monitor(*formula);
+      if (monitor_verdicts(monitor, trace) != evaluate_all(*formula, packed)) {
+        cout << "FAIL (truth table, monitor): " << formula->as_string()
+             << "\n";
+        return false;
+      }
+    }
+  }
+  // the table has one entry per assignment of the variables that occur,
+  // whatever their ids, and ids past the end of a state read as 0
+  shared_ptr<ASTNode> sparse = parse("(p2 & ~p1000) | (p40 <-> p1000)");
+  TruthTable sparse_table(*sparse);
+  for (int j = 0; j < 1000; ++j) {
+    string state(1001, '0');
+    for (size_t id : {2, 40, 1000}) {
+      state[id] = '0' + (mt() & 1);
+    }
+    if (sparse_table.evaluate(state, state.size()) !=
+        sparse->evaluate(Trace(vector<string>{state}))) {
+      cout << "FAIL (truth table): " << sparse->as_string() << "\n";
+      return false;
+    }
+  }
+  for (const string &f : {"G[0,3]((p0&p50000000))",
+                          "(p1|~p4000000000) U[0,5] (p0&p4000000000)"}) {
+    shared_ptr<ASTNode> formula = parse(f);
+    Monitor monitor(*formula);
+    if (monitor_verdicts(monitor, trace) != evaluate_all(*formula, packed)) {
+      cout << "FAIL (truth table, monitor): " << formula->as_string() << "\n";
+      return false;
+    }
+  }
+  if (is_tabulable(*parse("p0 & F[0,1]p1")) ||
+      is_tabulable(*parse("p0 & p1 & p2 & p3 & p4 & p5 & p6 & p7 & p8 & p9 & "
+                          "p10 & p11 & p12 & p13 & p14 & p15 & p16"))) {
+    cout << "FAIL (truth table): tabulable\n";
+    return false;
+  }
+  cout << "PASS (truth table)\n";
+  return true;
+}
+
+/* Checks that spec builds the same AST as the parser does for formula and
+ * evaluates like it on every trace.
+ */
+template <typename Spec>
+bool check_dsl_spec(Spec spec, const string &formula,
+                    const vector<vector<string>> &traces,
+                    const vector<Trace> &packed_traces) {
+  shared_ptr<ASTNode> expected = parse(formula);
+  if (*spec.to_ast() != *expected) {
+    cout << "FAIL (dsl): " << spec.to_ast()->as_string() << " instead of "
+         << expected->as_string() << "\n";
+    return false;
+  }
+  for (size_t j = 0; j < traces.size(); ++j) {
+    bool verdict = expected->evaluate(traces[j]);
+    if (spec.evaluate(traces[j]) != verdict ||
+        spec.evaluate(packed_traces[j]) != verdict) {
+      cout << "FAIL (dsl): " << formula << "\n      ";
+      for (const string &state : traces[j]) {
+        cout << state << " ";
+      }
+      cout << "\n";
+      return false;
+    }
+  }
+  return true;
+}
+
+bool check_dsl(const string &name, const vector<vector<string>> &traces) {
+  using namespace libmltl::dsl;
+  vector<Trace> packed_traces(traces.begin(), traces.end());
+  bool valid = true;
+  auto check = [&](auto spec, const string &formula) {
+    valid = check_dsl_spec(spec, formula, traces, packed_traces) && valid;
+  };
+  check(tt, "true");
+  check(!ff || p<1>, "~false|p1");
+  check(G<0, 2>(p<0> && !p<1>), "G[0,2](p0&~p1)");
+  check(F<1, 3>(p<1> ^ p<2>), "F[1,3](p1^p2)");
+  check(U<0, 2>(p<0>, implies(p<1>, p<0>)), "(p0)U[0,2](p1->p0)");
+  check(R<1, 2>(p<0> ^ p<1>, equiv(p<1>, p<0>)), "(p0^p1)R[1,2](p1<->p0)");
+  check(equiv(F<0, 1>(p<0>), G<2, 4>(!p<1>)), "F[0,1](p0)<->G[2,4](~p1)");
+  check(U<2, 4>(p<0>, R<0, 1>(p<1>, ff)), "(p0)U[2,4]((p1)R[0,1](false))");
+  check(G<0, 100>(implies(p<0>, F<0, 64>(p<2>))),
+        "G[0,100](p0->F[0,64](p2))");
+  check(U<0, 1000>(p<0>, p<2>), "(p0)U[0,1000](p2)");
+  check(R<10, 1000>(p<1>, p<0>), "(p1)R[10,1000](p0)");
+  cout << (valid ? "PASS (" : "FAIL (") << name << ")\n";
+  return valid;
+}
+
+/* Checks that a JIT cache directory other users can write to is never loaded
+ * from, that a missing one is created private, and that cache paths with
+ * quotes and spaces need no escaping.
+ */
+bool check_jit_cache(const ASTNode &formula, const vector<string> &trace) {
+  string dir = (filesystem::temp_directory_path() /
+                ("libmltl-jit-'check " + to_string(getpid())))
+                   .string();
+  filesystem::create_directories(dir);
+  filesystem::permissions(dir, filesystem::perms::all);
+  bool verdict = formula.evaluate(trace);
+  JitFormula first(formula, dir), second(formula, dir);
+  bool valid = !second.loaded_from_cache() &&
+               first.evaluate(trace) == verdict &&
+               second.evaluate(trace) == verdict;
+  if (!filesystem::is_empty(dir)) {
+    cout << "FAIL (JIT cache): wrote to a shared cache directory\n";
+    valid = false;
+  }
+  string private_dir = dir + "/private";
+  JitFormula third(formula, private_dir), fourth(formula, private_dir);
+  if (filesystem::status(private_dir).permissions() !=
+          filesystem::perms::owner_all ||
+      !fourth.loaded_from_cache() || fourth.evaluate(trace) != verdict) {
+    cout << "FAIL (JIT cache): private cache directory\n";
+    valid = false;
+  }
+  filesystem::remove_all(dir);
+  cout << (valid ? "PASS (JIT cache)\n" : "FAIL (JIT cache)\n");
+  return valid;
+}
+
 int main(int argc, char *argv[]) {
   // default options
   int max_vars = 2;
@@ -151,9 +1119,11 @@ int main(int argc, char *argv[]) {
                start.tv_usec / 1e6; // in seconds
   cout << "trace generation took: " << time_taken << "s\n";
 
+  // outlives the formulas made in it
+  ASTArena arena;
   vector<shared_ptr<ASTNode>> formulas;
   gettimeofday(&start, NULL); // start timer
-  generate_formulas(formulas, max_formula_depth, max_vars, max_ub);
+  generate_formulas(formulas, max_formula_depth, max_vars, max_ub, arena);
   gettimeofday(&end, NULL); // stop timer
   time_taken = end.tv_sec + end.tv_usec / 1e6 - start.tv_sec -
                start.tv_usec / 1e6; // in seconds
@@ -174,6 +1144,367 @@ int main(int argc, char *argv[]) {
                start.tv_usec / 1e6; // in seconds
   cout << "formula evaluation took: " << time_taken << "s\n";
 
+  vector<Trace> packed_traces(enumerated_traces.begin(),
+                              enumerated_traces.end());
+  vector<vector<bool>> packed_results(formulas.size(),
+                                      vector<bool>(num_traces, false));
+  gettimeofday(&start, NULL); // start timer
+  for (size_t i = 0; i < formulas.size(); ++i) {
+    for (size_t j = 0; j < num_traces; ++j) {
+      packed_results[i][j] = formulas[i]->evaluate(packed_traces[j]);
+    }
+  }
+  gettimeofday(&end, NULL); // stop timer
+  time_taken = end.tv_sec + end.tv_usec / 1e6 - start.tv_sec -
+               start.tv_usec / 1e6; // in seconds
+  cout << "packed trace evaluation took: " << time_taken << "s\n";
+  compare_results("packed trace", formulas, enumerated_traces, results,
+                  packed_results);
+
+  // the cache setup dominates on these short traces, check every 8th trace
+  vector<vector<string>> memo_traces;
+  vector<vector<bool>> memo_expected(formulas.size()),
+      memo_results(formulas.size());
+  for (size_t j = 0; j < num_traces; j += 8) {
+    memo_traces.push_back(enumerated_traces[j]);
+  }
+  gettimeofday(&start, NULL); // start timer
+  for (size_t i = 0; i < formulas.size(); ++i) {
+    for (size_t j = 0; j < num_traces; j += 8) {
+      memo_expected[i].push_back(results[i][j]);
+      memo_results[i].push_back(
+          formulas[i]->evaluate_memoized(packed_traces[j]));
+    }
+  }
+  gettimeofday(&end, NULL); // stop timer
+  time_taken = end.tv_sec + end.tv_usec / 1e6 - start.tv_sec -
+               start.tv_usec / 1e6; // in seconds
+  cout << "memoized evaluation took: " << time_taken << "s\n";
+  compare_results("memoized evaluation", formulas, memo_traces, memo_expected,
+                  memo_results);
+
+  vector<vector<bool>> compiled_results(formulas.size(),
+                                        vector<bool>(num_traces, false));
+  gettimeofday(&start, NULL); // start timer
+  for (size_t i = 0; i < formulas.size(); ++i) {
+    CompiledFormula compiled(*formulas[i]);
+    for (size_t j = 0; j < num_traces; ++j) {
+      compiled_results[i][j] = compiled.evaluate(packed_traces[j]);
+    }
+  }
+  gettimeofday(&end, NULL); // stop timer
+  time_taken = end.tv_sec + end.tv_usec / 1e6 - start.tv_sec -
+               start.tv_usec / 1e6; // in seconds
+  cout << "compiled evaluation took: " << time_taken << "s\n";
+  compare_results("compiled formula", formulas, enumerated_traces, results,
+                  compiled_results);
+
+  check_all_positions("evaluate_all", formulas, enumerated_traces, 16,
+                      [&](const ASTNode &formula, size_t j) {
+                        return evaluate_all(formula, packed_traces[j]);
+                      });
+  // the parser rejects ub < lb, but such intervals can still be constructed
+  auto p0 = make_shared<Variable>(0), p1 = make_shared<Variable>(1);
+  vector<shared_ptr<ASTNode>> empty_windows = {
+      make_shared<Finally>(p1, 5, 3), make_shared<Globally>(p1, 5, 3),
+      make_shared<Until>(p0, p1, 4, 3), make_shared<Release>(p0, p1, 4, 3),
+      make_shared<Release>(p0, p1, 5, 3)};
+  check_all_positions("evaluate_all empty windows", empty_windows,
+                      enumerated_traces, 1,
+                      [&](const ASTNode &formula, size_t j) {
+                        return evaluate_all(formula, packed_traces[j]);
+                      });
+
+  check_all_positions("intervals", formulas, enumerated_traces, 64,
+                      [&](const ASTNode &formula, size_t j) {
+                        return evaluate_intervals(
+                                   formula, IntervalTrace(packed_traces[j]))
+                            .to_bitvector(trace_length);
+                      });
+
+  check_all_positions("dictionary trace", formulas, enumerated_traces, 64,
+                      [&](const ASTNode &formula, size_t j) {
+                        return evaluate_all(
+                            formula, DictionaryTrace(enumerated_traces[j]));
+                      });
+
+  check_all_positions("monitor", formulas, enumerated_traces, 64,
+                      [&](const ASTNode &formula, size_t j) {
+                        Monitor monitor(formula);
+                        return monitor_verdicts(monitor,
+                                                enumerated_traces[j]);
+                      });
+  check_monitor_delay(formulas);
+
+  vector<size_t> prefix_lengths;
+  for (size_t length = 0; length <= trace_length; ++length) {
+    prefix_lengths.push_back(length);
+  }
+  // an odd stride, so the sampled traces differ in their first states
+  check_prefix("prefix verdicts", formulas, enumerated_traces, 255,
+               prefix_lengths);
+
+  // batches of 256 with a partial batch at the end
+  vector<vector<bool>> batch_results(formulas.size(),
+                                     vector<bool>(num_traces, false));
+  gettimeofday(&start, NULL); // start timer
+  for (size_t begin = 0; begin < num_traces; begin += 256) {
+    size_t end = min(begin + 256, num_traces);
+    TraceBatch batch(enumerated_traces, begin, end);
+    for (size_t i = 0; i < formulas.size(); ++i) {
+      BitVector verdicts = evaluate_batch(*formulas[i], batch);
+      for (size_t j = begin; j < end; ++j) {
+        batch_results[i][j] = verdicts[j - begin];
+      }
+    }
+  }
+  gettimeofday(&end, NULL); // stop timer
+  time_taken = end.tv_sec + end.tv_usec / 1e6 - start.tv_sec -
+               start.tv_usec / 1e6; // in seconds
+  cout << "batch evaluation took: " << time_taken << "s\n";
+  compare_results("evaluate_batch", formulas, enumerated_traces, results,
+                  batch_results);
+
+  // the empty windows, over the first batch
+  vector<vector<string>> first_traces(
+      enumerated_traces.begin(),
+      enumerated_traces.begin() + min<size_t>(256, num_traces));
+  TraceBatch first_batch(first_traces);
+  vector<vector<bool>> empty_expected, empty_actual;
+  for (const auto &formula : empty_windows) {
+    BitVector verdicts = evaluate_batch(*formula, first_batch);
+    empty_expected.emplace_back();
+    empty_actual.emplace_back();
+    for (size_t j = 0; j < first_traces.size(); ++j) {
+      empty_expected.back().push_back(formula->evaluate(first_traces[j]));
+      empty_actual.back().push_back(verdicts[j]);
+    }
+  }
+  compare_results("evaluate_batch empty windows", empty_windows, first_traces,
+                  empty_expected, empty_actual);
+
+  // the formula x trace matrix, with more threads than this machine may have
+  for (unsigned int num_threads : {1, 3, 8}) {
+    gettimeofday(&start, NULL); // start timer
+    vector<BitVector> matrix =
+        evaluate_batch(formulas, packed_traces, num_threads);
+    gettimeofday(&end, NULL); // stop timer
+    time_taken = end.tv_sec + end.tv_usec / 1e6 - start.tv_sec -
+                 start.tv_usec / 1e6; // in seconds
+    cout << "batch matrix evaluation (" << num_threads
+         << " threads) took: " << time_taken << "s\n";
+    compare_results("evaluate_batch matrix, " + to_string(num_threads) +
+                        " threads",
+                    formulas, enumerated_traces, results,
+                    matrix_rows(matrix));
+  }
+  check_thread_pool();
+
+  // parsing the generated formulas again drops the shared operands, so the
+  // context has to find the structurally identical subformulas itself
+  vector<shared_ptr<ASTNode>> reparsed_formulas;
+  for (const auto &formula : formulas) {
+    reparsed_formulas.push_back(parse(formula->as_string()));
+  }
+  EvaluationContext context(reparsed_formulas);
+  cout << "evaluation context nodes: " << context.num_nodes() << "\n";
+  vector<vector<bool>> context_results(formulas.size(),
+                                       vector<bool>(num_traces, false));
+  gettimeofday(&start, NULL); // start timer
+  for (size_t j = 0; j < num_traces; ++j) {
+    BitVector verdicts = context.evaluate(packed_traces[j]);
+    for (size_t i = 0; i < formulas.size(); ++i) {
+      context_results[i][j] = verdicts[i];
+    }
+  }
+  gettimeofday(&end, NULL); // stop timer
+  time_taken = end.tv_sec + end.tv_usec / 1e6 - start.tv_sec -
+               start.tv_usec / 1e6; // in seconds
+  cout << "evaluation context took: " << time_taken << "s\n";
+  compare_results("evaluation context", formulas, enumerated_traces, results,
+                  context_results);
+  if (context.num_nodes() > formulas.size() + (size_t)max_vars) {
+    cout << "FAIL (evaluation context): expected at most "
+         << formulas.size() + max_vars << " nodes\n";
+  }
+
+  check_simd_levels();
+  check_fused_kernels();
+  check_arena(formulas, packed_traces.back());
+  check_unique_formulas(formulas, packed_traces);
+  check_flat_formulas(formulas);
+  check_binary_setters();
+  check_factory(formulas);
+  check_compare(formulas);
+  check_dsl("dsl", enumerated_traces);
+
+  vector<shared_ptr<ASTNode>> long_formulas;
+  for (const string &f : long_trace_formulas) {
+    long_formulas.push_back(parse(f));
+  }
+  // the parser rejects empty windows (ub < lb), but they can be constructed
+  long_formulas.push_back(make_shared<Finally>(p1, 5, 3));
+  long_formulas.push_back(make_shared<Globally>(p1, 5, 3));
+  long_formulas.push_back(make_shared<Until>(p0, p1, 4, 3));
+  long_formulas.push_back(make_shared<Release>(p0, p1, 4, 3));
+  long_formulas.push_back(make_shared<Release>(p0, p1, 6, 3));
+  vector<vector<string>> long_traces = generate_long_traces(4, 3000);
+  vector<Trace> packed_long_traces(long_traces.begin(), long_traces.end());
+  check_all_positions("evaluate_all, long traces", long_formulas, long_traces,
+                      1, [&](const ASTNode &formula, size_t j) {
+                        return evaluate_all(formula, packed_long_traces[j]);
+                      });
+
+  check_all_positions("intervals, long traces", long_formulas, long_traces, 1,
+                      [&](const ASTNode &formula, size_t j) {
+                        return evaluate_intervals(
+                                   formula,
+                                   IntervalTrace(packed_long_traces[j]))
+                            .to_bitvector(long_traces[j].size());
+                      });
+  check_slow_signals(long_formulas, 20000000);
+  check_all_positions("dictionary trace, long traces", long_formulas,
+                      long_traces, 1, [&](const ASTNode &formula, size_t j) {
+                        return evaluate_all(formula,
+                                            DictionaryTrace(long_traces[j]));
+                      });
+  check_dictionary_widths(long_formulas);
+  check_truth_tables();
+
+  check_chunked("evaluate_all, chunked", long_formulas, packed_long_traces,
+                {1, 64, 100, 1000, 2999, 0});
+  vector<Trace> mission = {Trace(generate_long_traces(1, 1000000)[0])};
+  gettimeofday(&start, NULL); // start timer
+  check_chunked("evaluate_all, chunked mission", long_formulas, mission, {0});
+  gettimeofday(&end, NULL); // stop timer
+  time_taken = end.tv_sec + end.tv_usec / 1e6 - start.tv_sec -
+               start.tv_usec / 1e6; // in seconds
+  cout << "chunked evaluation check took: " << time_taken << "s\n";
+
+  vector<vector<string>> stream_traces = long_traces;
+  stream_traces.push_back({});
+  stream_traces.push_back({"01", "1", "110"});
+  check_stream("stream", long_formulas, stream_traces,
+               {1, 64, 100, 1000, default_stream_window});
+  {
+    string path = "stream_trace.txt";
+    ofstream(path) << "0,1,1\n1,1,1\n0,1,0\n";
+    ostringstream out;
+    evaluate_trace_file(*parse("G[0,1](p1) & F[1,2](p0)"), path, out);
+    // the run-length loader
+    if (read_trace_file<IntervalTrace>(path).to_trace().as_strings() !=
+        read_trace_file(path)) {
+      cout << "FAIL (interval trace file)\n";
+    }
+    if (read_trace_file<DictionaryTrace>(path).to_trace().as_strings() !=
+        read_trace_file(path)) {
+      cout << "FAIL (dictionary trace file)\n";
+    }
+    remove(path.c_str());
+    if (out.str() != "1\n0\n0\n") {
+      cout << "FAIL (stream file): wrote " << out.str() << "\n";
+    }
+  }
+
+  // the monitor is reset and reused for a second trace
+  check_all_positions("monitor, long traces", long_formulas, long_traces, 1,
+                      [&](const ASTNode &formula, size_t j) {
+                        Monitor monitor(formula);
+                        monitor_verdicts(monitor, long_traces[(j + 1) % 4]);
+                        return monitor_verdicts(monitor, long_traces[j]);
+                      });
+  check_monitor_delay(long_formulas);
+  check_prefix("prefix verdicts, long traces", long_formulas, long_traces, 1,
+               {0, 1, 2, 3, 10, 63, 64, 65, 100, 500, 1000, 2000, 3000});
+
+  // windows of the long traces at different offsets, one batch of 200
+  vector<vector<string>> long_windows;
+  for (const vector<string> &trace : long_traces) {
+    for (size_t offset = 0; offset < 1000; offset += 20) {
+      long_windows.emplace_back(trace.begin() + offset,
+                                trace.begin() + offset + 2000);
+    }
+  }
+  check_dsl("dsl, long traces", long_windows);
+  TraceBatch long_batch(long_windows);
+  vector<vector<bool>> long_expected, long_actual, long_memo, long_compiled;
+  for (const auto &formula : long_formulas) {
+    BitVector verdicts = evaluate_batch(*formula, long_batch);
+    CompiledFormula compiled(*formula);
+    long_expected.emplace_back();
+    long_actual.emplace_back();
+    long_memo.emplace_back();
+    long_compiled.emplace_back();
+    for (size_t j = 0; j < long_windows.size(); ++j) {
+      long_expected.back().push_back(formula->evaluate(long_windows[j]));
+      long_actual.back().push_back(verdicts[j]);
+      long_memo.back().push_back(
+          formula->evaluate_memoized(long_windows[j]));
+      long_compiled.back().push_back(compiled.evaluate(long_windows[j]));
+    }
+  }
+  compare_results("evaluate_batch, long traces", long_formulas, long_windows,
+                  long_expected, long_actual);
+
+  // blocks of windows with different lengths fall back to evaluate, the
+  // blocks of equal ones are bit-sliced
+  vector<vector<string>> mixed_traces = long_windows;
+  for (size_t j = 0; j < 150; ++j) {
+    mixed_traces[j].resize(1 + j * 13);
+  }
+  vector<vector<bool>> mixed_expected;
+  for (const auto &formula : long_formulas) {
+    mixed_expected.emplace_back();
+    for (const auto &trace : mixed_traces) {
+      mixed_expected.back().push_back(formula->evaluate(trace));
+    }
+  }
+  compare_results("evaluate_batch matrix, mixed lengths", long_formulas,
+                  mixed_traces, mixed_expected,
+                  matrix_rows(evaluate_batch(long_formulas, mixed_traces, 3)));
+  compare_results("memoized evaluation, long traces", long_formulas,
+                  long_windows, long_expected, long_memo);
+  compare_results("compiled formula, long traces", long_formulas,
+                  long_windows, long_expected, long_compiled);
+
+  // every compilation runs the C++ compiler, so only a sample of the formulas
+  // is JIT compiled: the long trace ones and every 500th generated one
+  vector<shared_ptr<ASTNode>> jit_formulas = long_formulas;
+  for (size_t i = 0; i < formulas.size(); i += 500) {
+    jit_formulas.push_back(formulas[i]);
+  }
+  vector<vector<bool>> jit_expected, jit_results;
+  bool jit_cached = true;
+  gettimeofday(&start, NULL); // start timer
+  for (const auto &formula : jit_formulas) {
+    JitFormula jit(*formula);
+    // the second instance must come from the disk cache
+    jit_cached = jit_cached && JitFormula(*formula).loaded_from_cache();
+    jit_expected.emplace_back();
+    jit_results.emplace_back();
+    for (const auto &trace : long_windows) {
+      jit_expected.back().push_back(formula->evaluate(trace));
+      jit_results.back().push_back(jit.evaluate(trace));
+    }
+    for (size_t j = 0; j < num_traces; ++j) {
+      jit_expected.back().push_back(formula->evaluate(enumerated_traces[j]));
+      jit_results.back().push_back(jit.evaluate(packed_traces[j]));
+    }
+  }
+  gettimeofday(&end, NULL); // stop timer
+  time_taken = end.tv_sec + end.tv_usec / 1e6 - start.tv_sec -
+               start.tv_usec / 1e6; // in seconds
+  cout << "JIT check took: " << time_taken << "s\n";
+  vector<vector<string>> jit_traces = long_windows;
+  jit_traces.insert(jit_traces.end(), enumerated_traces.begin(),
+                    enumerated_traces.end());
+  compare_results("JIT formula", jit_formulas, jit_traces, jit_expected,
+                  jit_results);
+  if (!jit_cached) {
+    cout << "FAIL (JIT formula): not loaded from the cache\n";
+  }
+  check_jit_cache(*jit_formulas.back(), long_windows.back());
+
   if (!outfilepath.empty()) {
     ofstream outfile(outfilepath);
     if (!outfile.is_open()) {